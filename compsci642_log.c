@@ -0,0 +1,1140 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+//  File          : compsci642_log.c
+//  Description   : This is the logging service for the COMPSCI642 utility
+//                  library.  See compsci642_log.h for the interface.
+//
+//   Note: Once a log is initialized, messages are not formatted on the
+//         calling thread.  Each thread appends a binary record (the format
+//         pointer plus a copy of the arguments) to its own lock-free
+//         single-producer ring, and a background drain thread formats the
+//         records in sequence order and writes them out in batches.  A full
+//         ring drops the message and counts it, so memory stays bounded.
+//         With every ring empty the drain thread sleeps on a condition
+//         variable, and the first record queued after that wakes it.
+//         The ring of a thread that exits is retired and freed by the drain
+//         thread once it is empty.  Stopping the log (re-initializing or
+//         freeing it) waits for threads in the middle of queuing a record;
+//         their later messages register new rings, or are written
+//         synchronously (after the output is switched) while it is stopped.
+//         Formats the recorder does not understand (e.g., %n) fall back to
+//         a synchronous write after flushing the queued records.
+//
+//  Author   : Max Mitchell
+//  Created  : Mon Oct 19 2026
+//
+
+// Include files
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+// Project include files
+#include <compsci642_log.h>
+
+//
+// Library Constants
+
+#define LOG_RING_SLOTS			1024	// Records per thread (power of 2)
+#define LOG_MAX_ARGS			16		// Arguments captured per record
+#define LOG_RECORD_STRINGS		MAX_LOG_MESSAGE_SIZE	// Bytes for %s copies
+#define LOG_SPEC_SIZE			64		// Longest conversion specification
+#define LOG_OUTPUT_BATCH		65536	// Bytes written per write() call
+#define LOG_DRAIN_IDLE_MSEC		100		// Longest drain sleep when there is no work
+#define LOG_FLUSH_POLL_NSEC		50000	// Flush poll while the drain catches up
+#define LOG_PRECISION_ARG		-2		// Precision given by a '*' argument
+
+//
+// Type definitions
+
+// Argument types captured from the format
+typedef enum {
+	LOG_ARG_INT,
+	LOG_ARG_LONG,
+	LOG_ARG_LLONG,
+	LOG_ARG_SIZE,
+	LOG_ARG_INTMAX,
+	LOG_ARG_PTRDIFF,
+	LOG_ARG_DOUBLE,
+	LOG_ARG_LDOUBLE,
+	LOG_ARG_PTR,
+	LOG_ARG_STR,
+	LOG_ARG_LONGSTR,
+	LOG_ARG_NULLSTR
+} LogArgType;
+
+// One captured argument
+typedef struct {
+	LogArgType type;
+	union {
+		long long i;		// Integer types
+		double d;			// double
+		long double ld;		// long double
+		const void *p;		// %p
+		uint32_t str;		// Offset of a copied %s in the record strings
+	} v;
+} LogArg;
+
+// Binary log record
+typedef struct {
+	uint64_t seq;							// Global order of the message
+	unsigned long lvl;						// Level of the message
+	const char *fmt;						// Format (must be a literal)
+	int nargs;								// Number of captured arguments
+	uint32_t strused;						// Bytes used in strings
+	LogArg args[LOG_MAX_ARGS];				// Captured arguments
+	char strings[LOG_RECORD_STRINGS];		// Copied string arguments
+} LogRecord;
+
+// Per-thread single-producer/single-consumer ring
+typedef struct LogRing {
+	_Atomic uint64_t head;					// Next slot to write (producer)
+	_Atomic uint64_t tail;					// Next slot to read (drain)
+	_Atomic int retired;					// Owner thread has exited
+	struct LogRing *next;					// Next registered ring (drain only)
+	LogRecord slots[LOG_RING_SLOTS];
+} LogRing;
+
+//
+// Global data
+
+static _Atomic unsigned long logLevel = DEFAULT_LOG_LEVEL;	// Enabled levels
+static char *descriptors[MAX_LOG_LEVEL];	// Level names, by bit
+static int fileHandle = -1;					// Log output
+static int echoHandle = -1;					// Echo output (-1 is none)
+static int ownsHandle = 0;					// fileHandle opened by us
+static char *logname = NULL;				// Log filename
+
+static _Atomic(LogRing *) rings = NULL;		// Registered rings
+static _Atomic uint64_t nextSeq = 0;		// Records enqueued
+static _Atomic uint64_t writtenSeq = 0;		// Records written out
+static _Atomic unsigned int generation = 1;	// Bumped when rings are freed
+static _Atomic int ringUsers = 0;			// Threads using their ring now
+static _Atomic unsigned long dropped = 0;	// Messages dropped when full
+static pthread_key_t ringKey;				// Retires the ring at thread exit
+static pthread_once_t ringKeyOnce = PTHREAD_ONCE_INIT;
+static _Atomic int asyncRunning = 0;		// Records are being queued
+static _Atomic int stopDrain = 0;			// Ask the drain thread to exit
+static _Atomic int drainWaiting = 0;		// Drain thread is going to sleep
+static pthread_mutex_t drainLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t drainWake = PTHREAD_COND_INITIALIZER;
+static pthread_mutex_t handleLock = PTHREAD_MUTEX_INITIALIZER;	// Synchronous writes
+static pthread_t drainThread;
+static int exitHandlerSet = 0;
+
+static _Thread_local LogRing *threadRing = NULL;		// This thread's ring
+static _Thread_local unsigned int threadGeneration = 0;	// Generation of it
+
+//
+// Functions
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// Function     : levelDescriptor
+// Description  : Get the name of the (lowest) level in a mask
+//
+// Inputs       : lvl - the level mask
+// Outputs      : the level name
+
+static const char *levelDescriptor( unsigned long lvl ) {
+
+	// Find the lowest level
+	for ( int i=0; i<MAX_LOG_LEVEL; i++ ) {
+		if ( (lvl & (1ul<<i)) && (descriptors[i] != NULL) ) {
+			return( descriptors[i] );
+		}
+	}
+	return( "*BAD LEVEL*" );
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// Function     : setDefaultDescriptors
+// Description  : Register the names of the default levels (once)
+//
+// Inputs       : none
+// Outputs      : none
+
+static void setDefaultDescriptors( void ) {
+
+	if ( descriptors[0] == NULL ) {
+		descriptors[0] = strdup( LOG_ERROR_LEVEL_DESC );
+		descriptors[1] = strdup( LOG_WARNING_LEVEL_DESC );
+		descriptors[2] = strdup( LOG_INFO_LEVEL_DESC );
+		descriptors[3] = strdup( LOG_OUTPUT_LEVEL_DESC );
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// Function     : writeAll
+// Description  : Write a buffer to the log (and the echo handle)
+//
+// Inputs       : buf - the bytes to write
+//                len - the number of bytes
+// Outputs      : 0 if successful, -1 if failure
+
+static int writeAll( const char *buf, size_t len ) {
+
+	int handles[2] = { fileHandle, echoHandle }, ret = 0;
+
+	for ( int h=0; h<2; h++ ) {
+		size_t off = 0;
+		if ( (handles[h] == -1) || ((h == 1) && (handles[1] == handles[0])) ) {
+			continue;
+		}
+		while ( off < len ) {
+			ssize_t n = write( handles[h], buf+off, len-off );
+			if ( n < 0 ) {
+				if ( errno == EINTR ) {
+					continue;
+				}
+				fprintf( stderr, "Error writing to log : %s [%s] (%d)\n",
+						strerror(errno), (logname != NULL) ? logname : "-", handles[h] );
+				ret = -1;
+				break;
+			}
+			off += n;
+		}
+	}
+	return( ret );
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// Function     : formatPrefix
+// Description  : Start a log line with the level name
+//
+// Inputs       : lvl - the level of the message
+//                out - the line buffer
+//                size - the size of the buffer
+// Outputs      : the number of bytes used
+
+static size_t formatPrefix( unsigned long lvl, char *out, size_t size ) {
+
+	int n = snprintf( out, size, "%s : ", levelDescriptor(lvl) );
+	return( ((n < 0) || ((size_t)n >= size)) ? 0 : (size_t)n );
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// Function     : parseSpec
+// Description  : Parse one conversion specification (fmt points after '%')
+//
+// Inputs       : fmt - the specification
+//                stars - the place to put the number of '*' arguments
+//                type - the place to put the argument type
+//                precision - the place to put the precision (-1 if none,
+//                            LOG_PRECISION_ARG if it is a '*' argument)
+// Outputs      : length of the specification, or -1 if not supported
+
+static int parseSpec( const char *fmt, int *stars, LogArgType *type, int *precision ) {
+
+	const char *p = fmt;
+	int longs = 0, shorts = 0, bigdbl = 0;
+	char size = 0;
+
+	// Flags, width and precision
+	*stars = 0;
+	*precision = -1;
+	while ( strchr("-+ #0'", *p) && (*p != '\0') ) p++;
+	if ( *p == '*' ) { (*stars)++; p++; } else { while ( (*p >= '0') && (*p <= '9') ) p++; }
+	if ( *p == '.' ) {
+		p++;
+		if ( *p == '*' ) {
+			(*stars)++;
+			*precision = LOG_PRECISION_ARG;
+			p++;
+		} else {
+			// Stop growing past the record size, that is all that matters
+			*precision = 0;
+			while ( (*p >= '0') && (*p <= '9') ) {
+				*precision = (*precision > LOG_RECORD_STRINGS) ? *precision
+					: (*precision * 10) + (*p - '0');
+				p++;
+			}
+		}
+	}
+
+	// Length modifiers
+	for ( ;; p++ ) {
+		if ( *p == 'l' ) longs++;
+		else if ( *p == 'h' ) shorts++;
+		else if ( *p == 'L' ) bigdbl = 1;
+		else if ( *p == 'q' ) longs = 2;
+		else if ( (*p == 'z') || (*p == 'j') || (*p == 't') ) size = *p;
+		else break;
+	}
+
+	// Conversion
+	switch ( *p ) {
+	case 'd': case 'i': case 'u': case 'o': case 'x': case 'X':
+		if ( size == 'z' ) *type = LOG_ARG_SIZE;
+		else if ( size == 'j' ) *type = LOG_ARG_INTMAX;
+		else if ( size == 't' ) *type = LOG_ARG_PTRDIFF;
+		else if ( longs >= 2 ) *type = LOG_ARG_LLONG;
+		else if ( longs == 1 ) *type = LOG_ARG_LONG;
+		else *type = LOG_ARG_INT;
+		break;
+	case 'c':
+		if ( longs ) return( -1 );
+		*type = LOG_ARG_INT;
+		break;
+	case 'f': case 'F': case 'e': case 'E': case 'g': case 'G': case 'a': case 'A':
+		*type = bigdbl ? LOG_ARG_LDOUBLE : LOG_ARG_DOUBLE;
+		break;
+	case 's':
+		if ( longs ) return( -1 );
+		*type = LOG_ARG_STR;
+		break;
+	case 'p':
+		*type = LOG_ARG_PTR;
+		break;
+	default:
+		// %n, wide characters and unknown conversions
+		return( -1 );
+	}
+	(void)shorts;
+	return( (int)(p - fmt) + 1 );
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// Function     : captureRecord
+// Description  : Copy the arguments of a message into a record
+//
+// Inputs       : rec - the record
+//                fmt - the format
+//                args - the arguments
+// Outputs      : 0 if successful, -1 if the format is not supported
+
+static int captureRecord( LogRecord *rec, const char *fmt, va_list args ) {
+
+	const char *p = fmt;
+	va_list ap;
+
+	va_copy( ap, args );
+	rec->nargs = 0;
+	rec->strused = 0;
+	while ( (p = strchr(p, '%')) != NULL ) {
+		int stars, len, precision;
+		LogArgType type;
+
+		if ( p[1] == '%' ) {
+			p += 2;
+			continue;
+		}
+		if ( ((len = parseSpec(p+1, &stars, &type, &precision)) < 0) ||
+				(rec->nargs + stars + 1 > LOG_MAX_ARGS) ) {
+			va_end( ap );
+			return( -1 );
+		}
+
+		// Star width/precision arguments come first
+		for ( int s=0; s<stars; s++ ) {
+			rec->args[rec->nargs].type = LOG_ARG_INT;
+			rec->args[rec->nargs++].v.i = va_arg( ap, int );
+		}
+		if ( precision == LOG_PRECISION_ARG ) {
+			// The precision is the last '*', a negative one means none
+			precision = (int)rec->args[rec->nargs-1].v.i;
+			precision = (precision < 0) ? -1 : precision;
+		}
+
+		LogArg *arg = &rec->args[rec->nargs++];
+		arg->type = type;
+		switch ( type ) {
+		case LOG_ARG_INT: arg->v.i = va_arg( ap, int ); break;
+		case LOG_ARG_LONG: arg->v.i = va_arg( ap, long ); break;
+		case LOG_ARG_LLONG: arg->v.i = va_arg( ap, long long ); break;
+		case LOG_ARG_SIZE: arg->v.i = (long long)va_arg( ap, size_t ); break;
+		case LOG_ARG_INTMAX: arg->v.i = (long long)va_arg( ap, intmax_t ); break;
+		case LOG_ARG_PTRDIFF: arg->v.i = (long long)va_arg( ap, ptrdiff_t ); break;
+		case LOG_ARG_DOUBLE: arg->v.d = va_arg( ap, double ); break;
+		case LOG_ARG_LDOUBLE: arg->v.ld = va_arg( ap, long double ); break;
+		case LOG_ARG_PTR: arg->v.p = va_arg( ap, void * ); break;
+		default: {
+			// Copy at most the precision (the string need not be terminated
+			// past it), truncating to the room left in the record
+			const char *str = va_arg( ap, const char * );
+			if ( str == NULL ) {
+				arg->type = LOG_ARG_NULLSTR;
+				break;
+			}
+			size_t room = LOG_RECORD_STRINGS - rec->strused - 1;
+			size_t limit = ((precision >= 0) && ((size_t)precision < room)) ? (size_t)precision : room;
+			size_t slen = strnlen( str, limit );
+			if ( (slen == room) && ((precision < 0) || ((size_t)precision > room)) &&
+					(str[slen] != '\0') ) {
+				arg->type = LOG_ARG_LONGSTR;
+			}
+			memcpy( &rec->strings[rec->strused], str, slen );
+			rec->strings[rec->strused + slen] = '\0';
+			arg->v.str = rec->strused;
+			rec->strused += slen + 1;
+			break;
+		}
+		}
+		p += len + 1;
+	}
+
+	va_end( ap );
+	rec->fmt = fmt;
+	return( 0 );
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// Function     : formatRecord
+// Description  : Format a record into a log line (drain thread)
+//
+// Inputs       : rec - the record
+//                out - the line buffer
+//                size - the size of the buffer (at least 2)
+// Outputs      : the length of the line (with the newline)
+
+static size_t formatRecord( LogRecord *rec, char *out, size_t size ) {
+
+	const char *p = rec->fmt;
+	size_t used = formatPrefix( rec->lvl, out, size - 1 );
+	int argi = 0;
+
+	while ( (*p != '\0') && (used < size - 1) ) {
+		char spec[LOG_SPEC_SIZE];
+		int stars, len, precision, n = 0, s = 0;
+		LogArgType type;
+
+		// Literal text (and %%)
+		if ( *p != '%' ) {
+			out[used++] = *p++;
+			continue;
+		}
+		if ( p[1] == '%' ) {
+			out[used++] = '%';
+			p += 2;
+			continue;
+		}
+
+		// Rebuild the specification with the '*' values filled in
+		len = parseSpec( p+1, &stars, &type, &precision );
+		spec[s++] = '%';
+		for ( int i=1; (i <= len) && (s < LOG_SPEC_SIZE - 16); i++ ) {
+			if ( p[i] != '*' ) {
+				spec[s++] = p[i];
+			} else if ( (p[i-1] == '.') && (rec->args[argi].v.i < 0) ) {
+				s--; // Negative precision means none, drop the '.'
+				argi++;
+			} else {
+				s += snprintf( &spec[s], 16, "%lld", rec->args[argi++].v.i );
+			}
+		}
+		spec[s] = '\0';
+
+		// A truncated string is printed as is (padding it would be wrong)
+		LogArg *arg = &rec->args[argi++];
+		if ( arg->type == LOG_ARG_LONGSTR ) {
+			strcpy( spec, "%s" );
+		}
+		char *dst = &out[used];
+		size_t room = size - 1 - used;
+		int isunsigned = (strchr("uoxX", p[len]) != NULL);
+		switch ( arg->type ) {
+		case LOG_ARG_INT:
+			n = isunsigned ? snprintf( dst, room, spec, (unsigned int)arg->v.i )
+				: snprintf( dst, room, spec, (int)arg->v.i );
+			break;
+		case LOG_ARG_LONG:
+			n = isunsigned ? snprintf( dst, room, spec, (unsigned long)arg->v.i )
+				: snprintf( dst, room, spec, (long)arg->v.i );
+			break;
+		case LOG_ARG_LLONG:
+			n = isunsigned ? snprintf( dst, room, spec, (unsigned long long)arg->v.i )
+				: snprintf( dst, room, spec, arg->v.i );
+			break;
+		case LOG_ARG_SIZE: n = snprintf( dst, room, spec, (size_t)arg->v.i ); break;
+		case LOG_ARG_INTMAX: n = snprintf( dst, room, spec, (intmax_t)arg->v.i ); break;
+		case LOG_ARG_PTRDIFF: n = snprintf( dst, room, spec, (ptrdiff_t)arg->v.i ); break;
+		case LOG_ARG_DOUBLE: n = snprintf( dst, room, spec, arg->v.d ); break;
+		case LOG_ARG_LDOUBLE: n = snprintf( dst, room, spec, arg->v.ld ); break;
+		case LOG_ARG_PTR: n = snprintf( dst, room, spec, arg->v.p ); break;
+		case LOG_ARG_STR:
+		case LOG_ARG_LONGSTR: n = snprintf( dst, room, spec, &rec->strings[arg->v.str] ); break;
+		case LOG_ARG_NULLSTR: n = snprintf( dst, room, spec, "(null)" ); break;
+		}
+		if ( n > 0 ) {
+			used += ((size_t)n < room) ? (size_t)n : room - 1;
+		}
+		p += len + 1;
+	}
+
+	out[used++] = '\n';
+	return( used );
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// Function     : wakeDrain
+// Description  : Wake the drain thread if it is asleep (or about to be)
+//
+// Inputs       : none
+// Outputs      : none
+
+static void wakeDrain( void ) {
+
+	pthread_mutex_lock( &drainLock );
+	atomic_store( &drainWaiting, 0 );
+	pthread_cond_signal( &drainWake );
+	pthread_mutex_unlock( &drainLock );
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// Function     : reclaimRings
+// Description  : Free the empty rings of exited threads (drain thread)
+//
+// Inputs       : none
+// Outputs      : none
+
+static void reclaimRings( void ) {
+
+	LogRing *prev = NULL, *r = atomic_load( &rings );
+
+	while ( r != NULL ) {
+		LogRing *next = r->next;
+		if ( atomic_load_explicit(&r->retired, memory_order_acquire) &&
+				(atomic_load_explicit(&r->tail, memory_order_relaxed) ==
+				 atomic_load_explicit(&r->head, memory_order_acquire)) ) {
+
+			// Rings are only pushed at the front, the rest of the list is ours
+			LogRing *expected = r;
+			if ( (prev != NULL) || atomic_compare_exchange_strong(&rings, &expected, next) ) {
+				if ( prev != NULL ) {
+					prev->next = next;
+				}
+				free( r );
+				r = next;
+				continue;
+			}
+			// A ring was registered in front of it, try again next time
+		}
+		prev = r;
+		r = next;
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// Function     : waitForRecords
+// Description  : Sleep the drain thread until a record is queued, it is
+//                stopped or LOG_DRAIN_IDLE_MSEC passes
+//
+// Inputs       : none
+// Outputs      : none
+
+static void waitForRecords( void ) {
+
+	struct timespec until;
+
+	// Announce the sleep before the last look at the rings, so a producer
+	// either sees the announcement or its record is seen here
+	atomic_store( &drainWaiting, 1 );
+	atomic_thread_fence( memory_order_seq_cst );
+	for ( LogRing *r = atomic_load(&rings); r != NULL; r = r->next ) {
+		if ( atomic_load_explicit(&r->tail, memory_order_relaxed) !=
+				atomic_load_explicit(&r->head, memory_order_acquire) ) {
+			atomic_store( &drainWaiting, 0 );
+			return;
+		}
+	}
+
+	clock_gettime( CLOCK_REALTIME, &until );
+	until.tv_nsec += (LOG_DRAIN_IDLE_MSEC % 1000) * 1000000L;
+	until.tv_sec += (LOG_DRAIN_IDLE_MSEC / 1000) + (until.tv_nsec / 1000000000L);
+	until.tv_nsec %= 1000000000L;
+	pthread_mutex_lock( &drainLock );
+	while ( atomic_load(&drainWaiting) && !atomic_load(&stopDrain) ) {
+		if ( pthread_cond_timedwait(&drainWake, &drainLock, &until) == ETIMEDOUT ) {
+			break;
+		}
+	}
+	pthread_mutex_unlock( &drainLock );
+	atomic_store( &drainWaiting, 0 );
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// Function     : drainLog
+// Description  : Background thread that formats and writes the records of
+//                every ring in sequence order
+//
+// Inputs       : arg - unused
+// Outputs      : NULL
+
+static void *drainLog( void *arg ) {
+
+	char *batch = malloc( LOG_OUTPUT_BATCH );
+	size_t used = 0;
+	uint64_t pending = 0;
+	unsigned long reportedDrops = 0;
+
+	if ( batch == NULL ) {
+		return( NULL );
+	}
+
+	for ( ;; ) {
+		LogRing *best = NULL;
+		uint64_t bestSeq = 0;
+
+		// Pick the oldest published record across the rings
+		for ( LogRing *r = atomic_load(&rings); r != NULL; r = r->next ) {
+			uint64_t tail = atomic_load_explicit( &r->tail, memory_order_relaxed );
+			if ( tail != atomic_load_explicit(&r->head, memory_order_acquire) ) {
+				uint64_t seq = r->slots[tail & (LOG_RING_SLOTS-1)].seq;
+				if ( (best == NULL) || (seq < bestSeq) ) {
+					best = r;
+					bestSeq = seq;
+				}
+			}
+		}
+
+		// Nothing to do, write out the batch and report drops
+		if ( best == NULL ) {
+			unsigned long drops = logDroppedMessages();
+			if ( drops != reportedDrops ) {
+				int n = snprintf( batch+used, LOG_OUTPUT_BATCH-used,
+						"%s : %lu log messages dropped (queue full)\n",
+						LOG_SERVICE_NAME, drops - reportedDrops );
+				used += ((n > 0) && ((size_t)n < LOG_OUTPUT_BATCH-used)) ? (size_t)n : 0;
+				reportedDrops = drops;
+			}
+			if ( used > 0 ) {
+				writeAll( batch, used );
+				used = 0;
+			}
+			atomic_fetch_add( &writtenSeq, pending );
+			pending = 0;
+			if ( atomic_load(&stopDrain) ) {
+				break;
+			}
+			reclaimRings();
+			waitForRecords();
+			continue;
+		}
+
+		// Keep room for a full line in the batch
+		if ( LOG_OUTPUT_BATCH - used < MAX_LOG_MESSAGE_SIZE + 2 ) {
+			writeAll( batch, used );
+			used = 0;
+			atomic_fetch_add( &writtenSeq, pending );
+			pending = 0;
+		}
+		uint64_t tail = atomic_load_explicit( &best->tail, memory_order_relaxed );
+		used += formatRecord( &best->slots[tail & (LOG_RING_SLOTS-1)], batch+used,
+				MAX_LOG_MESSAGE_SIZE + 2 );
+		atomic_store_explicit( &best->tail, tail+1, memory_order_release );
+		pending++;
+	}
+
+	free( batch );
+	(void)arg;
+	return( NULL );
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// Function     : exitFlush
+// Description  : atexit() handler, writes out queued messages
+//
+// Inputs       : none
+// Outputs      : none
+
+static void exitFlush( void ) {
+	flushLog();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// Function     : startAsyncLog
+// Description  : Start the drain thread (falls back to synchronous logging)
+//
+// Inputs       : none
+// Outputs      : 0 if successful, -1 if failure
+
+static int startAsyncLog( void ) {
+
+	if ( atomic_load(&asyncRunning) ) {
+		return( 0 );
+	}
+	atomic_store( &stopDrain, 0 );
+	if ( pthread_create(&drainThread, NULL, drainLog, NULL) != 0 ) {
+		return( -1 );
+	}
+	atomic_store( &asyncRunning, 1 );
+	if ( !exitHandlerSet ) {
+		atexit( exitFlush );
+		exitHandlerSet = 1;
+	}
+	return( 0 );
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// Function     : stopAsyncLog
+// Description  : Flush, stop the drain thread and free the rings
+//
+// Inputs       : none
+// Outputs      : none
+
+static void stopAsyncLog( void ) {
+
+	if ( !atomic_load(&asyncRunning) ) {
+		return;
+	}
+
+	// Send new messages to the synchronous path, and wait for the threads
+	// still queuing one (see vlogMessage) before draining the rings
+	atomic_store( &asyncRunning, 0 );
+	while ( atomic_load(&ringUsers) > 0 ) {
+		struct timespec wait = { 0, LOG_FLUSH_POLL_NSEC };
+		nanosleep( &wait, NULL );
+	}
+	uint64_t target = atomic_load( &nextSeq );
+	while ( atomic_load(&writtenSeq) < target ) {
+		struct timespec wait = { 0, LOG_FLUSH_POLL_NSEC };
+		nanosleep( &wait, NULL );
+	}
+	atomic_store( &stopDrain, 1 );
+	wakeDrain();
+	pthread_join( drainThread, NULL );
+
+	// Threads holding a ring from this generation will register a new one
+	atomic_fetch_add( &generation, 1 );
+	LogRing *r = atomic_exchange( &rings, NULL );
+	while ( r != NULL ) {
+		LogRing *next = r->next;
+		free( r );
+		r = next;
+	}
+	atomic_store( &dropped, 0 );
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// Function     : retireThreadRing
+// Description  : Thread exit destructor, hands the ring to the drain thread
+//
+// Inputs       : ring - the exiting thread's ring
+// Outputs      : none
+
+static void retireThreadRing( void *ring ) {
+
+	// A ring of an earlier generation has already been freed
+	atomic_fetch_add( &ringUsers, 1 );
+	if ( atomic_load(&asyncRunning) && (ring == threadRing) &&
+			(threadGeneration == atomic_load(&generation)) ) {
+		atomic_store_explicit( &((LogRing *)ring)->retired, 1, memory_order_release );
+	}
+	atomic_fetch_sub( &ringUsers, 1 );
+
+	// Messages from later exit handlers of the thread get a new ring
+	threadRing = NULL;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// Function     : createRingKey
+// Description  : Create the thread key that retires rings (once)
+//
+// Inputs       : none
+// Outputs      : none
+
+static void createRingKey( void ) {
+	pthread_key_create( &ringKey, retireThreadRing );
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// Function     : getThreadRing
+// Description  : Get (registering on first use) the calling thread's ring
+//
+// Inputs       : none
+// Outputs      : the ring, or NULL if it cannot be allocated
+
+static LogRing *getThreadRing( void ) {
+
+	unsigned int gen = atomic_load( &generation );
+
+	if ( (threadRing == NULL) || (threadGeneration != gen) ) {
+		LogRing *r = calloc( 1, sizeof(LogRing) );
+		if ( r == NULL ) {
+			return( NULL );
+		}
+		pthread_once( &ringKeyOnce, createRingKey );
+		pthread_setspecific( ringKey, r );
+
+		// Lock-free push onto the ring list
+		r->next = atomic_load( &rings );
+		while ( !atomic_compare_exchange_weak(&rings, &r->next, r) );
+		threadRing = r;
+		threadGeneration = gen;
+	}
+	return( threadRing );
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// Function     : registerLogLevel
+// Description  : Register a new log level
+//
+// Inputs       : descriptor - the name of the level
+//                enable - turn the level on
+// Outputs      : the level mask, 0 if no levels are left
+
+unsigned long registerLogLevel( const char *descriptor, int enable ) {
+
+	setDefaultDescriptors();
+	for ( int i=0; i<MAX_LOG_LEVEL; i++ ) {
+		if ( descriptors[i] == NULL ) {
+			descriptors[i] = strdup( descriptor );
+			if ( enable ) {
+				enableLogLevels( 1ul<<i );
+			}
+			return( 1ul<<i );
+		}
+	}
+	fprintf( stderr, "Too many log levels [%s]\n", descriptor );
+	return( 0 );
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// Function     : enableLogLevels
+// Description  : Turn on different log levels
+//
+// Inputs       : lvl - the levels
+// Outputs      : none
+
+void enableLogLevels( unsigned long lvl ) {
+	atomic_fetch_or( &logLevel, lvl );
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// Function     : disableLogLevels
+// Description  : Turn off different log levels
+//
+// Inputs       : lvl - the levels
+// Outputs      : none
+
+void disableLogLevels( unsigned long lvl ) {
+	atomic_fetch_and( &logLevel, ~lvl );
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// Function     : levelEnabled
+// Description  : Are any of the log levels turned on?
+//
+// Inputs       : lvl - the levels
+// Outputs      : 1 if any is on, 0 otherwise
+
+int levelEnabled( unsigned long lvl ) {
+	return( (atomic_load_explicit(&logLevel, memory_order_relaxed) & lvl) != 0 );
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// Function     : setEchoDescriptor
+// Description  : Set a file handle to echo content to
+//
+// Inputs       : eh - the file handle
+// Outputs      : none
+
+void setEchoDescriptor( int eh ) {
+	flushLog();
+	pthread_mutex_lock( &handleLock );
+	echoHandle = eh;
+	pthread_mutex_unlock( &handleLock );
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// Function     : initializeLogWithFilename
+// Description  : Create a log with a given filename
+//
+// Inputs       : logname - the file to log to
+// Outputs      : 0 if successful, -1 if failure
+
+int initializeLogWithFilename( const char *name ) {
+
+	int fd = open( name, O_WRONLY|O_CREAT|O_APPEND, 0644 );
+	if ( fd == -1 ) {
+		fprintf( stderr, "Error opening log : %s (%s)\n", name, strerror(errno) );
+		return( -1 );
+	}
+
+	pthread_mutex_lock( &handleLock );
+	stopAsyncLog();
+	if ( ownsHandle ) {
+		close( fileHandle );
+	}
+	free( logname );
+	logname = strdup( name );
+	fileHandle = fd;
+	ownsHandle = 1;
+	setDefaultDescriptors();
+	startAsyncLog();
+	pthread_mutex_unlock( &handleLock );
+	return( 0 );
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// Function     : initializeLogWithFilehandle
+// Description  : Create a log with a fixed file handle
+//
+// Inputs       : out - the file handle (e.g., COMPSCI642_LOG_STDOUT)
+// Outputs      : 0 if successful, -1 if failure
+
+int initializeLogWithFilehandle( int out ) {
+
+	pthread_mutex_lock( &handleLock );
+	stopAsyncLog();
+	if ( ownsHandle ) {
+		close( fileHandle );
+		ownsHandle = 0;
+	}
+	free( logname );
+	logname = NULL;
+	fileHandle = (out == COMPSCI642_LOG_STDERR) ? STDERR_FILENO
+		: (out == COMPSCI642_LOG_STDOUT) ? STDOUT_FILENO : out;
+	setDefaultDescriptors();
+	startAsyncLog();
+	pthread_mutex_unlock( &handleLock );
+	return( 0 );
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// Function     : freeLogRegistrations
+// Description  : Flush the log and cleanup all of the registrations
+//
+// Inputs       : none
+// Outputs      : 0 if successful
+
+int freeLogRegistrations( void ) {
+
+	pthread_mutex_lock( &handleLock );
+	stopAsyncLog();
+	if ( ownsHandle ) {
+		close( fileHandle );
+		ownsHandle = 0;
+	}
+	fileHandle = -1;
+	free( logname );
+	logname = NULL;
+	for ( int i=0; i<MAX_LOG_LEVEL; i++ ) {
+		free( descriptors[i] );
+		descriptors[i] = NULL;
+	}
+	atomic_store( &logLevel, DEFAULT_LOG_LEVEL );
+	pthread_mutex_unlock( &handleLock );
+	return( 0 );
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// Function     : flushLog
+// Description  : Wait until every queued message has been written
+//
+// Inputs       : none
+// Outputs      : 0 if successful
+
+int flushLog( void ) {
+
+	uint64_t target = atomic_load( &nextSeq );
+	while ( atomic_load(&asyncRunning) && (atomic_load(&writtenSeq) < target) ) {
+		struct timespec wait = { 0, LOG_FLUSH_POLL_NSEC };
+		nanosleep( &wait, NULL );
+	}
+	return( 0 );
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// Function     : logDroppedMessages
+// Description  : Get the number of messages dropped because a queue was full
+//
+// Inputs       : none
+// Outputs      : the number of dropped messages
+
+unsigned long logDroppedMessages( void ) {
+
+	return( atomic_load_explicit(&dropped, memory_order_relaxed) );
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// Function     : logMessage
+// Description  : Log a "printf"-style message
+//
+// Inputs       : lvl - the level of the message
+//                fmt - the format
+//                ... - the arguments
+// Outputs      : 0 if successful, -1 if failure
+
+int logMessage( unsigned long lvl, const char *fmt, ...) {
+
+	va_list args;
+	int ret;
+
+	va_start( args, fmt );
+	ret = vlogMessage( lvl, fmt, args );
+	va_end( args );
+	return( ret );
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// Function     : queueRecord
+// Description  : Queue a message on the calling thread's ring
+//
+// Inputs       : lvl - the level of the message
+//                fmt - the format
+//                args - the arguments
+// Outputs      : 0 if queued (or dropped), -1 if it must be written now
+
+static int queueRecord( unsigned long lvl, const char *fmt, va_list args ) {
+
+	LogRing *r = getThreadRing();
+	if ( r == NULL ) {
+		return( -1 );
+	}
+	uint64_t head = atomic_load_explicit( &r->head, memory_order_relaxed );
+	if ( head - atomic_load_explicit(&r->tail, memory_order_acquire) == LOG_RING_SLOTS ) {
+		atomic_fetch_add_explicit( &dropped, 1, memory_order_relaxed );
+		return( 0 );
+	}
+	LogRecord *rec = &r->slots[head & (LOG_RING_SLOTS-1)];
+	if ( captureRecord(rec, fmt, args) != 0 ) {
+		return( -1 );
+	}
+	rec->lvl = lvl;
+	rec->seq = atomic_fetch_add( &nextSeq, 1 );
+	atomic_store_explicit( &r->head, head+1, memory_order_release );
+
+	// The drain only sleeps with every ring empty (see waitForRecords)
+	atomic_thread_fence( memory_order_seq_cst );
+	if ( atomic_load_explicit(&drainWaiting, memory_order_relaxed) ) {
+		wakeDrain();
+	}
+	return( 0 );
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// Function     : vlogMessage
+// Description  : Log call the vararg list version
+//
+// Inputs       : lvl - the level of the message
+//                fmt - the format
+//                args - the arguments
+// Outputs      : 0 if successful, -1 if failure
+
+int vlogMessage( unsigned long lvl, const char *fmt, va_list args ) {
+
+	char line[MAX_LOG_MESSAGE_SIZE + 2];
+	size_t used;
+	int queued = -1;
+
+	if ( !levelEnabled(lvl) ) {
+		return( 0 );
+	}
+
+	// Queue the binary record, counted in ringUsers so that stopAsyncLog
+	// never frees the ring under us
+	atomic_fetch_add( &ringUsers, 1 );
+	if ( atomic_load(&asyncRunning) ) {
+		queued = queueRecord( lvl, fmt, args );
+	}
+	atomic_fetch_sub( &ringUsers, 1 );
+	if ( queued == 0 ) {
+		return( 0 );
+	}
+
+	// Not recordable, keep the order by flushing first
+	flushLog();
+
+	// Synchronous write, never while the output is being switched
+	pthread_mutex_lock( &handleLock );
+	used = formatPrefix( lvl, line, MAX_LOG_MESSAGE_SIZE );
+	int n = vsnprintf( line+used, MAX_LOG_MESSAGE_SIZE-used, fmt, args );
+	if ( n > 0 ) {
+		used += ((size_t)n < MAX_LOG_MESSAGE_SIZE-used) ? (size_t)n : MAX_LOG_MESSAGE_SIZE-used-1;
+	}
+	line[used++] = '\n';
+	int ret = writeAll( line, used );
+	pthread_mutex_unlock( &handleLock );
+	return( ret );
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// Function     : logBufferMessage
+// Description  : Show a buffer with a specified lable (data in hex)
+//
+// Inputs       : lvl - the level of the message
+//                label - the label of the buffer
+//                buf - the buffer
+//                len - the length of the buffer
+// Outputs      : 0 if successful, -1 if failure
+
+int logBufferMessage( unsigned long lvl, const char *label, const char *buf, uint32_t len ) {
+
+	char hex[MAX_LOG_MESSAGE_SIZE];
+	size_t used = 0;
+
+	if ( !levelEnabled(lvl) ) {
+		return( 0 );
+	}
+
+	// Convert as much of the buffer as fits
+	for ( uint32_t i=0; (i < len) && (used + 6 < sizeof(hex)); i++ ) {
+		used += snprintf( hex+used, sizeof(hex)-used, "0x%02x ", (uint8_t)buf[i] );
+	}
+	hex[used] = '\0';
+	return( logMessage(lvl, "%s : %s", label, hex) );
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// Function     : logAssert
+// Description  : Log a "printf"-style message where ASSERT fails, then abort
+//
+// Inputs       : expr - the asserted expression
+//                file - the source file
+//                line - the source line
+//                fmt - the format
+//                ... - the arguments
+// Outputs      : 0 if the assertion holds (does not return otherwise)
+
+int logAssert( int expr, const char *file,  int line, const char *fmt, ...) {
+
+	va_list args;
+
+	if ( expr ) {
+		return( 0 );
+	}
+	logMessage( LOG_ERROR_LEVEL, "LOG_ASSERT_FAILED: %s @ line %d", file, line );
+	va_start( args, fmt );
+	vlogMessage( LOG_ERROR_LEVEL, fmt, args );
+	va_end( args );
+	flushLog();
+	abort();
+}
@@ -7,6 +7,8 @@
 //  Description   : This is the logging service for the COMPSCI642 utility
 //                  library.  It provides access enable log events,
 //                  whose levels are registered by the calling programs.
+//                  Messages are queued per thread and written by a
+//                  background thread (see compsci642_log.c).
 //
 //   Note: The log process works on a bit-vector of levels, and all
 //         functions operate on bit masks of levels (lvl).  Log entries are
@@ -71,10 +73,20 @@ int initializeLogWithFilehandle( int out );
 	// Create a log with a fixed file handle
 
 int freeLogRegistrations( void );
-	// Cleanup all of the registrations
+	// Flush the log and cleanup all of the registrations
+
+int flushLog( void );
+	// Wait until every queued message has been written
+
+unsigned long logDroppedMessages( void );
+	// Number of messages dropped because a thread's queue was full
 
 //
 // Logging functions
+//
+// Note: messages are formatted later on a background thread, so the format
+//       string must stay valid (normally a literal).  String arguments are
+//       copied when the message is logged.
 
 int logMessage( unsigned long lvl, const char *fmt, ...);
 	// Log a "printf"-style message
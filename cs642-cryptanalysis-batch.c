@@ -0,0 +1,414 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+//  File           : cs642-cryptanalysis-batch.c
+//  Description    : This is the sharded batch runner for the cryptanalysis
+//                   solvers. Each process maps the record file and takes the
+//                   records whose byte midpoint falls in its slice of the
+//                   file, so shards are contiguous, balanced by bytes rather
+//                   than records, and need no coordination. Results go to a
+//                   per-shard file (renamed into place when complete) and the
+//                   merge step joins them in shard order with the statistics.
+//
+//   Author        : Max Mitchell
+//   Last Modified : October 19th, 2026
+//
+
+// Include Files
+#include <compsci642_log.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+// Project Include Files
+#include "cs642-cryptanalysis-support.h"
+#include "cs642-cryptanalysis-impl.h"
+#include "cs642-cryptanalysis-batch.h"
+
+// Defines
+#define BATCH_NUM_CIPHERS CIPHER_UNK
+#define BATCH_MAX_KEY 32
+#define BATCH_MAX_PATH 4096
+
+// Per cipher statistics of a shard (or of the merged run)
+typedef struct {
+    int records; // Records solved
+    long bytes;  // Ciphertext bytes
+    int solved;  // Records the solver reported success on
+    double usec; // Time spent in the solver
+} BatchStats;
+
+//
+// Functions
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// Function     : batchParseCipher
+// Description  : Helper function to look up a cipher by its name
+//
+// Inputs       : name - the name (as in cs642CipherStrings)
+//                len - the length of the name
+// Outputs      : the cipher, CIPHER_UNK if not found
+
+cs642Cipher batchParseCipher(const char *name, int len) {
+    for (cs642Cipher cipher = CIPHER_ROTX; cipher < BATCH_NUM_CIPHERS; cipher++) {
+        if ((int)strlen(cs642CipherStrings[cipher]) == len &&
+            strncmp(cs642CipherStrings[cipher], name, len) == 0) {
+            return cipher;
+        }
+    }
+    return CIPHER_UNK;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// Function     : batchFormatKey
+// Description  : Helper function to print a recovered key
+//
+// Inputs       : out - the place to write the key
+//                cipher - the cipher
+//                key - the key
+// Outputs      : void
+
+void batchFormatKey(FILE *out, cs642Cipher cipher, const char *key) {
+    switch (cipher) {
+    case CIPHER_ROTX:
+        fprintf(out, "%d", (uint8_t)key[0]);
+        break;
+    case CIPHER_AFFI:
+        fprintf(out, "%d,%d", (uint8_t)key[0], (uint8_t)key[1]);
+        break;
+    case CIPHER_SUBS:
+        fprintf(out, "%.26s", key);
+        break;
+    default:
+        fprintf(out, "%s", key);
+        break;
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// Function     : batchWriteStats
+// Description  : Helper function to write the statistics lines of a run
+//
+// Inputs       : out - the place to write the statistics
+//                stats - the per cipher statistics
+// Outputs      : void
+
+void batchWriteStats(FILE *out, BatchStats *stats) {
+    for (cs642Cipher cipher = CIPHER_ROTX; cipher < BATCH_NUM_CIPHERS; cipher++) {
+        fprintf(out, "# stats %s %d %ld %d %.1f\n", cs642CipherStrings[cipher],
+                stats[cipher].records, stats[cipher].bytes, stats[cipher].solved,
+                stats[cipher].usec);
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// Function     : batchCommitFile
+// Description  : Helper function to close a finished output file and move it
+//                into place, so readers never see a partial file
+//
+// Inputs       : out - the open temporary file
+//                tmp_path - the temporary file name
+//                path - the final file name
+// Outputs      : 0 if successful, -1 if failure
+
+int batchCommitFile(FILE *out, const char *tmp_path, const char *path) {
+    int failed = ferror(out);
+
+    if (fclose(out) || failed || rename(tmp_path, path)) {
+        logMessage(LOG_ERROR_LEVEL, "Failed to write batch output %s", path);
+        unlink(tmp_path);
+        return -1;
+    }
+    return 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// Function     : cs642BatchGenerate
+// Description  : Write random sample records (every cipher) to a file
+//
+// Inputs       : count - the number of records
+//                out - the place to write the records
+// Outputs      : 0 if successful, -1 if failure
+
+int cs642BatchGenerate(int count, FILE *out) {
+    for (int i = 0; i < count; i++) {
+        cs642Cipher cipher = (cs642Cipher)(rand() % BATCH_NUM_CIPHERS);
+        char *ciphertext = cs642GetCiphertextSample(cipher);
+        if (ciphertext == NULL) {
+            return -1;
+        }
+        fprintf(out, "%s %s\n", cs642CipherStrings[cipher], ciphertext);
+        free(ciphertext);
+    }
+    return ferror(out) ? -1 : 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// Function     : cs642BatchRunShard
+// Description  : Solve the records of one shard. Record i belongs to shard
+//                floor(midpoint(i) * num_shards / file size), which every
+//                process computes on its own from the same file.
+//
+// Inputs       : records - the record file
+//                shard - the shard to run (0 to num_shards - 1)
+//                num_shards - the number of shards
+//                output - the output name (the shard writes <output>.<shard>)
+// Outputs      : 0 if successful, -1 if failure
+
+int cs642BatchRunShard(const char *records, int shard, int num_shards,
+                       const char *output) {
+    char path[BATCH_MAX_PATH], tmp_path[BATCH_MAX_PATH];
+    char key[BATCH_MAX_KEY];
+    BatchStats stats[BATCH_NUM_CIPHERS];
+    struct stat st;
+
+    if (shard < 0 || shard >= num_shards) {
+        return -1;
+    }
+    snprintf(path, sizeof(path), "%s.%d", output, shard);
+    snprintf(tmp_path, sizeof(tmp_path), "%s.%d.tmp", output, shard);
+
+    // Map the records
+    int fd = open(records, O_RDONLY);
+    if (fd == -1 || fstat(fd, &st) == -1 || st.st_size == 0) {
+        logMessage(LOG_ERROR_LEVEL, "Failed to open record file %s", records);
+        if (fd != -1) {
+            close(fd);
+        }
+        return -1;
+    }
+    const char *text = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (text == MAP_FAILED) {
+        logMessage(LOG_ERROR_LEVEL, "Failed to map record file %s", records);
+        return -1;
+    }
+    size_t size = st.st_size;
+
+    FILE *out = fopen(tmp_path, "w");
+    if (out == NULL) {
+        logMessage(LOG_ERROR_LEVEL, "Failed to create batch output %s", tmp_path);
+        munmap((void *)text, size);
+        return -1;
+    }
+    fprintf(out, "# shard %d/%d %s\n", shard, num_shards, records);
+
+    memset(stats, 0, sizeof(stats));
+    char *ciphertext = NULL, *plaintext = NULL;
+    int allocated = 0, index = 0, ret = 0;
+    size_t pos = 0;
+    while (pos < size && ret == 0) {
+        // Next line (the last one may have no newline)
+        const char *line = text + pos;
+        const char *eol = memchr(line, '\n', size - pos);
+        size_t len = (eol != NULL) ? (size_t)(eol - line) : size - pos;
+        size_t midpoint = pos + len / 2;
+        pos += len + 1;
+        if (len > 0 && line[len - 1] == '\r') {
+            len--;
+        }
+        if (len == 0) {
+            continue;
+        }
+        int record = index++;
+        if ((int)((uint64_t)midpoint * num_shards / size) != shard) {
+            continue;
+        }
+
+        // Split the cipher name from the ciphertext
+        const char *space = memchr(line, ' ', len);
+        cs642Cipher cipher = (space != NULL) ? batchParseCipher(line, space - line) : CIPHER_UNK;
+        if (cipher == CIPHER_UNK) {
+            logMessage(LOG_ERROR_LEVEL, "Bad record %d in %s, skipping.", record, records);
+            continue;
+        }
+        int clen = len - (space + 1 - line);
+
+        // Grow the work buffers as needed
+        if (clen + 1 > allocated) {
+            char *temp_buffer = realloc(ciphertext, clen + 1);
+            if (temp_buffer == NULL) {
+                ret = -1;
+                break;
+            }
+            ciphertext = temp_buffer;
+            temp_buffer = realloc(plaintext, clen + 1);
+            if (temp_buffer == NULL) {
+                ret = -1;
+                break;
+            }
+            plaintext = temp_buffer;
+            allocated = clen + 1;
+        }
+        memcpy(ciphertext, space + 1, clen);
+        ciphertext[clen] = '\0';
+        memset(plaintext, 0, clen + 1);
+        memset(key, 0, sizeof(key));
+
+        // Time only the solver
+        struct timespec start, end;
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        int result = cs642PerformCryptanalysis(cipher, ciphertext, clen, plaintext, clen, key);
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        double usec = (end.tv_sec - start.tv_sec) * 1e6 + (end.tv_nsec - start.tv_nsec) / 1e3;
+
+        fprintf(out, "%d\t%s\t%d\t%.1f\t", record, cs642CipherStrings[cipher], result, usec);
+        batchFormatKey(out, cipher, key);
+        fprintf(out, "\t%s\n", plaintext);
+
+        stats[cipher].records++;
+        stats[cipher].bytes += clen;
+        stats[cipher].solved += (result == 0);
+        stats[cipher].usec += usec;
+    }
+
+    free(ciphertext);
+    free(plaintext);
+    munmap((void *)text, size);
+    if (ret) {
+        fclose(out);
+        unlink(tmp_path);
+        return -1;
+    }
+
+    batchWriteStats(out, stats);
+    if (batchCommitFile(out, tmp_path, path)) {
+        return -1;
+    }
+
+    int total_records = 0;
+    long total_bytes = 0;
+    for (cs642Cipher cipher = CIPHER_ROTX; cipher < BATCH_NUM_CIPHERS; cipher++) {
+        total_records += stats[cipher].records;
+        total_bytes += stats[cipher].bytes;
+    }
+    logMessage(LOG_OUTPUT_LEVEL, "Shard %d/%d solved [%d] records, [%ld] bytes, into %s",
+               shard, num_shards, total_records, total_bytes, path);
+    return 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// Function     : cs642BatchMerge
+// Description  : Combine the shard outputs of a run into one file, records in
+//                file order, with the statistics summed over the shards
+//
+// Inputs       : output - the output name (shards are <output>.<shard>)
+//                num_shards - the number of shards
+// Outputs      : 0 if successful, -1 if failure
+
+int cs642BatchMerge(const char *output, int num_shards) {
+    char path[BATCH_MAX_PATH], tmp_path[BATCH_MAX_PATH];
+    BatchStats stats[BATCH_NUM_CIPHERS];
+    char *line = NULL;
+    size_t line_size = 0;
+    int ret = 0;
+
+    snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", output);
+    FILE *out = fopen(tmp_path, "w");
+    if (out == NULL) {
+        logMessage(LOG_ERROR_LEVEL, "Failed to create batch output %s", tmp_path);
+        return -1;
+    }
+    fprintf(out, "# merged %d shards\n", num_shards);
+
+    memset(stats, 0, sizeof(stats));
+    for (int shard = 0; shard < num_shards && ret == 0; shard++) {
+        int in_shard, in_num_shards;
+
+        snprintf(path, sizeof(path), "%s.%d", output, shard);
+        FILE *in = fopen(path, "r");
+        if (in == NULL) {
+            logMessage(LOG_ERROR_LEVEL, "Missing shard output %s", path);
+            ret = -1;
+            break;
+        }
+
+        // The header must match the run being merged
+        if (getline(&line, &line_size, in) == -1 ||
+            sscanf(line, "# shard %d/%d", &in_shard, &in_num_shards) != 2 ||
+            in_shard != shard || in_num_shards != num_shards) {
+            logMessage(LOG_ERROR_LEVEL, "Shard output %s is not shard %d/%d", path,
+                       shard, num_shards);
+            fclose(in);
+            ret = -1;
+            break;
+        }
+
+        while (getline(&line, &line_size, in) != -1) {
+            char name[32];
+            BatchStats shard_stats;
+
+            if (sscanf(line, "# stats %31s %d %ld %d %lf", name, &shard_stats.records,
+                       &shard_stats.bytes, &shard_stats.solved, &shard_stats.usec) == 5) {
+                cs642Cipher cipher = batchParseCipher(name, strlen(name));
+                if (cipher != CIPHER_UNK) {
+                    stats[cipher].records += shard_stats.records;
+                    stats[cipher].bytes += shard_stats.bytes;
+                    stats[cipher].solved += shard_stats.solved;
+                    stats[cipher].usec += shard_stats.usec;
+                }
+            } else if (line[0] != '#') {
+                fputs(line, out);
+            }
+        }
+        fclose(in);
+    }
+    free(line);
+    if (ret) {
+        fclose(out);
+        unlink(tmp_path);
+        return -1;
+    }
+
+    batchWriteStats(out, stats);
+    if (batchCommitFile(out, tmp_path, output)) {
+        return -1;
+    }
+
+    for (cs642Cipher cipher = CIPHER_ROTX; cipher < BATCH_NUM_CIPHERS; cipher++) {
+        if (stats[cipher].records > 0) {
+            logMessage(LOG_OUTPUT_LEVEL, "%s: [%d] records, [%ld] bytes, [%d] solved, %.1f usec/record",
+                       cs642CipherStrings[cipher], stats[cipher].records, stats[cipher].bytes,
+                       stats[cipher].solved, stats[cipher].usec / stats[cipher].records);
+        }
+    }
+    return 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// Function     : cs642ParseShard
+// Description  : Parse a shard argument
+//
+// Inputs       : arg - the argument ("<index>/<count>", e.g. "2/8")
+//                shard - the place to put the index
+//                num_shards - the place to put the count
+// Outputs      : 0 if successful, -1 if the argument is bad
+
+int cs642ParseShard(const char *arg, int *shard, int *num_shards) {
+    char *end;
+
+    long index = strtol(arg, &end, 10);
+    if (end == arg || *end != '/') {
+        return -1;
+    }
+    const char *p = end + 1;
+    long count = strtol(p, &end, 10);
+    if (end == p || *end != '\0' || count < 1 || count > CS642_BATCH_MAX_SHARDS ||
+        index < 0 || index >= count) {
+        return -1;
+    }
+    *shard = (int)index;
+    *num_shards = (int)count;
+    return 0;
+}
@@ -0,0 +1,43 @@
+#ifndef CS642_CRYPTANALYSIS_BATCH_INCLUDED
+#define CS642_CRYPTANALYSIS_BATCH_INCLUDED
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  File           : cs642-cryptanalysis-batch.h
+//  Description    : This is an include file for the sharded batch runner. A
+//                   record file holds one ciphertext per line, as
+//                   "<cipher> <ciphertext>" with the cipher named as in
+//                   cs642CipherStrings. Every process of a run takes the
+//                   shard of the file it is given, writes <output>.<shard>,
+//                   and a merge step combines the shard outputs into
+//                   <output>.
+//
+//   Author        : Max Mitchell
+//   Last Modified : October 19th, 2026
+//
+
+// Include Files
+#include <stdio.h>
+
+//
+// Defines
+
+#define CS642_BATCH_MAX_SHARDS 1024
+
+//
+// Functions
+
+int cs642BatchGenerate(int count, FILE *out);
+// Write count random sample records (every cipher) to out
+
+int cs642BatchRunShard(const char *records, int shard, int num_shards,
+                       const char *output);
+// Solve the records of one shard, writing the results to <output>.<shard>
+
+int cs642BatchMerge(const char *output, int num_shards);
+// Combine <output>.0 to <output>.<num_shards - 1> into <output>
+
+int cs642ParseShard(const char *arg, int *shard, int *num_shards);
+// Parse a shard argument "<index>/<count>", returns 0 if good (-1 if bad)
+
+#endif
@@ -0,0 +1,667 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+//  File           : cs642-cryptanalysis-characterize.c
+//  Description    : This is the accuracy-vs-length characterization of the
+//                   cryptanalysis solvers. For each cipher and plaintext
+//                   length it encrypts random corpus passages under random
+//                   keys, runs the solver, and reports how often the key and
+//                   plaintext come back, so length thresholds can be chosen
+//                   from data instead of guessed.
+//
+//   Author        : Max Mitchell
+//   Last Modified : October 19th, 2026
+//
+
+// Include Files
+#include <compsci642_log.h>
+#include <ctype.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// Project Include Files
+#include "cs642-cryptanalysis-support.h"
+#include "cs642-cryptanalysis-impl.h"
+#include "cs642-cryptanalysis-corpus.h"
+#include "cs642-cryptanalysis-characterize.h"
+
+// Defines
+#define CHARACTERIZE_MAX_KEY 32
+#define CHARACTERIZE_MIN_WORD_KEY 6   // Shortest corpus word used as a key
+#define CHARACTERIZE_MAX_WORD_KEY 11  // Longest corpus word used as a key
+#define CHARACTERIZE_WORD_KEY_TRIES 1000
+#define CHARACTERIZE_ONLINE_CHUNK 64  // Bytes fed to the online estimator at once
+
+// Per cipher and length accumulated results
+typedef struct {
+    int trials;          // Trials run
+    int keys_recovered;  // Trials with the exact key
+    double key_fraction; // Sum of the fraction of key positions right
+    int texts_recovered; // Trials with the exact plaintext
+    double seconds;      // Time spent in the solver
+} CharacterizeResult;
+
+//
+// Functions
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// Function     : randomPlaintext
+// Description  : Helper function to cut a random passage from the corpus in
+//                the form of the project samples: whole paragraphs,
+//                uppercased, every run of non-letters in a paragraph one
+//                space and two spaces between paragraphs
+//
+// Inputs       : buf - the place to put the passage (len + 1 chars)
+//                len - the length of the passage
+// Outputs      : 0 if successful, -1 if failure
+
+int randomPlaintext(char *buf, int len) {
+    size_t tlen;
+    const char *text = cs642CorpusText(&tlen);
+    if (text == NULL) {
+        return -1;
+    }
+
+    // Start at the beginning of a paragraph (just after a blank line)
+    size_t pos = (size_t)rand() % tlen;
+    int newlines = 0;
+    while (pos < tlen && !(newlines >= 2 && isalpha((uint8_t)text[pos]))) {
+        if (text[pos] == '\n') {
+            newlines++;
+        } else if (isalpha((uint8_t)text[pos])) {
+            newlines = 0;
+        }
+        pos++;
+    }
+
+    // Copy, counting the line breaks in each run of non-letters
+    int n = 0, gap = 0;
+    newlines = 0;
+    while (n < len) {
+        if (pos >= tlen) {
+            pos = 0;
+            gap = 1;
+            newlines = 2;
+        }
+        uint8_t ch = (uint8_t)text[pos++];
+        if (!isalpha(ch)) {
+            gap = 1;
+            newlines += (ch == '\n');
+            continue;
+        }
+        if (n > 0 && gap) {
+            buf[n++] = ' ';
+            if (newlines >= 2 && n < len) {
+                buf[n++] = ' ';
+            }
+        }
+        if (n < len) {
+            buf[n++] = toupper(ch);
+        }
+        gap = 0;
+        newlines = 0;
+    }
+    // Null Terminate
+    buf[len] = '\0';
+    return 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// Function     : randomWordKey
+// Description  : Helper function to draw a random 6-11 letter corpus word as
+//                a Vigenere key (uppercased)
+//
+// Inputs       : key - the place to put the key (CHARACTERIZE_MAX_KEY chars)
+// Outputs      : the key length, 0 if no word was found
+
+int randomWordKey(char *key) {
+    int num_words = cs642CorpusSize();
+    if (num_words <= 0) {
+        return 0;
+    }
+
+    for (int tries = 0; tries < CHARACTERIZE_WORD_KEY_TRIES; tries++) {
+        CorpusWord word = cs642CorpusGetWord(rand() % num_words);
+        if (word.length >= CHARACTERIZE_MIN_WORD_KEY &&
+            word.length <= CHARACTERIZE_MAX_WORD_KEY) {
+            for (int i = 0; i < word.length; i++) {
+                key[i] = toupper((uint8_t)word.word[i]);
+            }
+            return word.length;
+        }
+    }
+    return 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// Function     : randomKey
+// Description  : Helper function to generate a random key for a cipher
+//
+// Inputs       : cipher - the cipher
+//                key - the place to put the key (CHARACTERIZE_MAX_KEY chars)
+//                word_keys - draw Vigenere keys from the corpus words
+// Outputs      : the key length
+
+int randomKey(cs642Cipher cipher, char *key, int word_keys) {
+    int affine_a[26], num_a;
+    int keylen = 0;
+
+    memset(key, 0, CHARACTERIZE_MAX_KEY);
+    switch (cipher) {
+    case CIPHER_ROTX:
+        key[0] = 1 + rand() % 25;
+        keylen = 1;
+        break;
+    case CIPHER_AFFI:
+        num_a = affineMultipliers(26, affine_a);
+        key[0] = affine_a[rand() % num_a];
+        key[1] = rand() % 26;
+        keylen = 2;
+        break;
+    case CIPHER_VIGE:
+        // A dictionary word, or random letters (the 6-11 letter keys of the project)
+        if (word_keys && (keylen = randomWordKey(key)) > 0) {
+            break;
+        }
+        keylen = 6 + rand() % 6;
+        for (int i = 0; i < keylen; i++) {
+            key[i] = 'A' + rand() % 26;
+        }
+        break;
+    case CIPHER_SUBS:
+        // Fisher-Yates shuffle of the alphabet
+        for (int i = 0; i < 26; i++) {
+            key[i] = 'A' + i;
+        }
+        for (int i = 25; i > 0; i--) {
+            int j = rand() % (i + 1);
+            char tmp = key[i];
+            key[i] = key[j];
+            key[j] = tmp;
+        }
+        keylen = 26;
+        break;
+    default:
+        break;
+    }
+    return keylen;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// Function     : keyAccuracy
+// Description  : Helper function to compare a recovered key with the real one
+//
+// Inputs       : cipher - the cipher
+//                real - the real key
+//                keylen - the real key length
+//                found - the recovered key
+//                plaintext - the plaintext (SUBS only scores letters in it)
+// Outputs      : the fraction of key positions recovered (1.0 is exact)
+
+double keyAccuracy(cs642Cipher cipher, const char *real, int keylen,
+                   const char *found, const char *plaintext) {
+    int right = 0, total = 0;
+
+    switch (cipher) {
+    case CIPHER_VIGE: {
+        // A key that repeats the real one (multiple period) still counts
+        int flen = strlen(found);
+        total = (flen > keylen) ? flen : keylen;
+        for (int i = 0; i < total; i++) {
+            right += (flen > 0 && found[i % flen] == real[i % keylen]);
+        }
+        break;
+    }
+    case CIPHER_SUBS: {
+        // Letters absent from the plaintext cannot be recovered
+        int present[26] = {0};
+        for (int i = 0; plaintext[i] != '\0'; i++) {
+            if (isalpha((uint8_t)plaintext[i])) {
+                present[plaintext[i] - 'A'] = 1;
+            }
+        }
+        for (int l = 0; l < 26; l++) {
+            if (present[l]) {
+                right += (found[l] == real[l]);
+                total++;
+            }
+        }
+        break;
+    }
+    default:
+        for (int i = 0; i < keylen; i++) {
+            right += (found[i] == real[i]);
+        }
+        total = keylen;
+        break;
+    }
+    return (total > 0) ? (double)right / total : 1.0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// Function     : cs642CharacterizeSolvers
+// Description  : Run trials of every solver at each plaintext length and
+//                write one CSV row per cipher and length
+//
+// Inputs       : trials - the number of trials per cipher and length
+//                lengths - the plaintext lengths to sweep
+//                num_lengths - the number of lengths
+//                word_keys - draw Vigenere keys from the corpus words
+//                out - the place to write the CSV
+// Outputs      : 0 if successful, -1 if failure
+
+int cs642CharacterizeSolvers(int trials, const int *lengths, int num_lengths,
+                             int word_keys, FILE *out) {
+    char real_key[CHARACTERIZE_MAX_KEY], found_key[CHARACTERIZE_MAX_KEY];
+    int max_len = 0;
+
+    for (int l = 0; l < num_lengths; l++) {
+        if (lengths[l] > max_len) {
+            max_len = lengths[l];
+        }
+    }
+    char *plaintext = (char *)malloc(max_len + 1);
+    char *ciphertext = (char *)malloc(max_len + 1);
+    char *recovered = (char *)malloc(max_len + 1);
+    if (plaintext == NULL || ciphertext == NULL || recovered == NULL) {
+        free(plaintext);
+        free(ciphertext);
+        free(recovered);
+        return -1;
+    }
+
+    fprintf(out, "cipher,length,trials,key_recovery,partial_key,plaintext_recovery,usec_per_trial\n");
+    for (cs642Cipher cipher = CIPHER_ROTX; cipher < CIPHER_UNK; cipher++) {
+        for (int l = 0; l < num_lengths; l++) {
+            CharacterizeResult res = {0, 0, 0.0, 0, 0.0};
+            int len = lengths[l];
+
+            for (int t = 0; t < trials; t++) {
+                struct timespec start, end;
+
+                if (randomPlaintext(plaintext, len)) {
+                    free(plaintext);
+                    free(ciphertext);
+                    free(recovered);
+                    return -1;
+                }
+                int keylen = randomKey(cipher, real_key, word_keys);
+                cs642Encrypt(cipher, real_key, keylen, plaintext, len, ciphertext, len);
+                ciphertext[len] = '\0';
+                memset(recovered, 0, len + 1);
+                memset(found_key, 0, sizeof(found_key));
+
+                // Time only the solver
+                clock_gettime(CLOCK_MONOTONIC, &start);
+                cs642PerformCryptanalysis(cipher, ciphertext, len, recovered, len, found_key);
+                clock_gettime(CLOCK_MONOTONIC, &end);
+
+                double accuracy = keyAccuracy(cipher, real_key, keylen, found_key, plaintext);
+                res.trials++;
+                res.keys_recovered += (accuracy == 1.0);
+                res.key_fraction += accuracy;
+                res.texts_recovered += (memcmp(recovered, plaintext, len) == 0);
+                res.seconds += (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+            }
+
+            fprintf(out, "%s,%d,%d,%.4f,%.4f,%.4f,%.1f\n", cs642CipherStrings[cipher],
+                    len, res.trials, (double)res.keys_recovered / res.trials,
+                    res.key_fraction / res.trials, (double)res.texts_recovered / res.trials,
+                    res.seconds * 1e6 / res.trials);
+            fflush(out);
+        }
+    }
+
+    free(plaintext);
+    free(ciphertext);
+    free(recovered);
+    return 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// Function     : encryptVigenereFamily
+// Description  : Helper function to encrypt under one Vigenere family sign
+//                convention (the project only encrypts plain Vigenere).
+//                Non-letters pass through but still take a key position.
+//
+// Inputs       : plaintext - the plaintext to encrypt
+//                len - the length of the plaintext
+//                ciphertext - the place to put the ciphertext (len chars)
+//                key - the key (uppercase letters)
+//                keylen - the key length
+//                variant - the sign convention to encrypt under
+// Outputs      : void
+
+void encryptVigenereFamily(const char *plaintext, int len, char *ciphertext,
+                           const char *key, int keylen,
+                           cs642VigenereVariant variant) {
+    for (int i = 0, col = 0; i < len; i++) {
+        if (isalpha((uint8_t)plaintext[i])) {
+            int p = toupper((uint8_t)plaintext[i]) - 'A';
+            int k = key[col] - 'A';
+            int c;
+            switch (variant) {
+            case VIGE_VARIANT_BEAUFORT:
+                c = k - p;
+                break;
+            case VIGE_VARIANT_VARIANT_BEAUFORT:
+                c = p - k;
+                break;
+            default:
+                c = p + k;
+                break;
+            }
+            ciphertext[i] = 'A' + (c + 26) % 26;
+        } else {
+            ciphertext[i] = plaintext[i];
+        }
+        if (++col == keylen) {
+            col = 0;
+        }
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// Function     : cs642CharacterizeVigenereFamily
+// Description  : Run trials of the Vigenere family solver under each sign
+//                convention at each plaintext length and write one CSV row
+//                per variant and length. Variant Beaufort cannot be told from
+//                Vigenere under the negated key, so for it the solver is
+//                right when it reports that Vigenere equivalent.
+//
+// Inputs       : trials - the number of trials per variant and length
+//                lengths - the plaintext lengths to sweep
+//                num_lengths - the number of lengths
+//                word_keys - draw the keys from the corpus words
+//                out - the place to write the CSV
+// Outputs      : 0 if successful, -1 if failure
+
+int cs642CharacterizeVigenereFamily(int trials, const int *lengths,
+                                    int num_lengths, int word_keys, FILE *out) {
+    static const char *variant_names[VIGE_VARIANT_MAX] = {
+        "Vigenere", "Beaufort", "Variant Beaufort"};
+    char real_key[CHARACTERIZE_MAX_KEY], expected_key[CHARACTERIZE_MAX_KEY];
+    char found_key[CHARACTERIZE_MAX_KEY];
+    int max_len = 0;
+
+    for (int l = 0; l < num_lengths; l++) {
+        if (lengths[l] > max_len) {
+            max_len = lengths[l];
+        }
+    }
+    char *plaintext = (char *)malloc(max_len + 1);
+    char *ciphertext = (char *)malloc(max_len + 1);
+    char *recovered = (char *)malloc(max_len + 1);
+    if (plaintext == NULL || ciphertext == NULL || recovered == NULL) {
+        free(plaintext);
+        free(ciphertext);
+        free(recovered);
+        return -1;
+    }
+
+    fprintf(out, "variant,length,trials,variant_detection,key_recovery,partial_key,plaintext_recovery,usec_per_trial\n");
+    for (int v = 0; v < VIGE_VARIANT_MAX; v++) {
+        // The variant the solver should report (variant Beaufort reads as Vigenere)
+        cs642VigenereVariant expected = (v == VIGE_VARIANT_VARIANT_BEAUFORT) ?
+            VIGE_VARIANT_VIGENERE : (cs642VigenereVariant)v;
+
+        for (int l = 0; l < num_lengths; l++) {
+            CharacterizeResult res = {0, 0, 0.0, 0, 0.0};
+            int detected = 0;
+            int len = lengths[l];
+
+            for (int t = 0; t < trials; t++) {
+                struct timespec start, end;
+                cs642VigenereVariant found;
+
+                if (randomPlaintext(plaintext, len)) {
+                    free(plaintext);
+                    free(ciphertext);
+                    free(recovered);
+                    return -1;
+                }
+                int keylen = randomKey(CIPHER_VIGE, real_key, word_keys);
+                encryptVigenereFamily(plaintext, len, ciphertext, real_key, keylen, v);
+                ciphertext[len] = '\0';
+
+                // Variant Beaufort under K is Vigenere under -K
+                memset(expected_key, 0, sizeof(expected_key));
+                for (int i = 0; i < keylen; i++) {
+                    expected_key[i] = (v == VIGE_VARIANT_VARIANT_BEAUFORT) ?
+                        'A' + (26 - (real_key[i] - 'A')) % 26 : real_key[i];
+                }
+                memset(recovered, 0, len + 1);
+                memset(found_key, 0, sizeof(found_key));
+
+                // Time only the solver
+                clock_gettime(CLOCK_MONOTONIC, &start);
+                cs642PerformVIGEFamilyCryptanalysis(ciphertext, len, recovered, len,
+                                                    found_key, &found);
+                clock_gettime(CLOCK_MONOTONIC, &end);
+
+                double accuracy = keyAccuracy(CIPHER_VIGE, expected_key, keylen, found_key, plaintext);
+                res.trials++;
+                detected += (found == expected);
+                res.keys_recovered += (found == expected && accuracy == 1.0);
+                res.key_fraction += (found == expected) ? accuracy : 0.0;
+                res.texts_recovered += (memcmp(recovered, plaintext, len) == 0);
+                res.seconds += (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+            }
+
+            fprintf(out, "%s,%d,%d,%.4f,%.4f,%.4f,%.4f,%.1f\n", variant_names[v],
+                    len, res.trials, (double)detected / res.trials,
+                    (double)res.keys_recovered / res.trials, res.key_fraction / res.trials,
+                    (double)res.texts_recovered / res.trials,
+                    res.seconds * 1e6 / res.trials);
+            fflush(out);
+        }
+    }
+
+    free(plaintext);
+    free(ciphertext);
+    free(recovered);
+    return 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// Function     : cs642CharacterizeAlphabet
+// Description  : Run trials of the Affine solver over one alphabet at each
+//                plaintext length and write one CSV row per length
+//
+// Inputs       : trials - the number of trials per length
+//                lengths - the plaintext lengths to sweep
+//                num_lengths - the number of lengths
+//                size - the alphabet size
+//                out - the place to write the CSV
+// Outputs      : 0 if successful, -1 if failure
+
+int cs642CharacterizeAlphabet(int trials, const int *lengths, int num_lengths,
+                              int size, FILE *out) {
+    const cs642Alphabet *alpha = cs642GetAlphabet(size);
+    int affine_a[CS642_ALPHABET_MAX];
+    uint8_t found_key[2];
+    int max_len = 0;
+
+    if (alpha == NULL) {
+        logMessage(LOG_ERROR_LEVEL, "No alphabet of %d symbols", size);
+        return -1;
+    }
+    int num_a = affineMultipliers(alpha->size, affine_a);
+
+    for (int l = 0; l < num_lengths; l++) {
+        if (lengths[l] > max_len) {
+            max_len = lengths[l];
+        }
+    }
+    char *plaintext = (char *)malloc(max_len + 1);
+    char *ciphertext = (char *)malloc(max_len + 1);
+    char *recovered = (char *)malloc(max_len + 1);
+    if (plaintext == NULL || ciphertext == NULL || recovered == NULL) {
+        free(plaintext);
+        free(ciphertext);
+        free(recovered);
+        return -1;
+    }
+
+    fprintf(out, "alphabet,length,trials,key_recovery,plaintext_recovery,usec_per_trial\n");
+    for (int l = 0; l < num_lengths; l++) {
+        CharacterizeResult res = {0, 0, 0.0, 0, 0.0};
+        int len = lengths[l];
+
+        for (int t = 0; t < trials; t++) {
+            struct timespec start, end;
+
+            if (randomPlaintext(plaintext, len)) {
+                free(plaintext);
+                free(ciphertext);
+                free(recovered);
+                return -1;
+            }
+            int a = affine_a[rand() % num_a], b = rand() % alpha->size;
+            encryptAffine(alpha, plaintext, len, ciphertext, a, b);
+            memset(recovered, 0, len + 1);
+
+            // Time only the solver
+            clock_gettime(CLOCK_MONOTONIC, &start);
+            cs642PerformAlphabetAFFICryptanalysis(alpha, ciphertext, len, recovered, len, found_key);
+            clock_gettime(CLOCK_MONOTONIC, &end);
+
+            res.trials++;
+            res.keys_recovered += (found_key[0] == a && found_key[1] == b);
+            res.texts_recovered += (memcmp(recovered, plaintext, len) == 0);
+            res.seconds += (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+        }
+
+        fprintf(out, "%d,%d,%d,%.4f,%.4f,%.1f\n", alpha->size, len, res.trials,
+                (double)res.keys_recovered / res.trials,
+                (double)res.texts_recovered / res.trials, res.seconds * 1e6 / res.trials);
+        fflush(out);
+    }
+
+    free(plaintext);
+    free(ciphertext);
+    free(recovered);
+    return 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// Function     : cs642CheckOnlineEstimator
+// Description  : Check the online key estimator against the full solvers. Each
+//                project sample is fed to the estimator in chunks, querying
+//                after every chunk, and the key it converges to must match the
+//                key cs642PerformCryptanalysis finds for the whole sample (which
+//                the project checks, releasing the sample).
+//
+// Inputs       : trials - the number of samples per cipher
+//                out - the place to write the CSV
+// Outputs      : 0 if every converged key matched, -1 if not (or failure)
+
+int cs642CheckOnlineEstimator(int trials, FILE *out) {
+    char online_key[CHARACTERIZE_MAX_KEY], last_key[CHARACTERIZE_MAX_KEY];
+    char solver_key[CHARACTERIZE_MAX_KEY];
+    int result = 0;
+
+    fprintf(out, "cipher,trials,agreement,converged_bytes,sample_bytes\n");
+    for (cs642Cipher cipher = CIPHER_ROTX; cipher <= CIPHER_VIGE; cipher++) {
+        int agreed = 0;
+        double converged = 0.0, sample_bytes = 0.0;
+
+        for (int t = 0; t < trials; t++) {
+            cs642OnlineEstimator est;
+            double confidence;
+            int keylen = 0, settled = 0;
+
+            char *ciphertext = cs642GetCiphertextSample(cipher);
+            if (ciphertext == NULL) {
+                return -1;
+            }
+            int clen = strlen(ciphertext);
+            char *plaintext = (char *)malloc(clen + 1);
+            if (plaintext == NULL || cs642OnlineInit(&est, cipher)) {
+                free(plaintext);
+                free(ciphertext);
+                return -1;
+            }
+
+            // Feed the stream, noting where the key last changed
+            memset(last_key, 0, sizeof(last_key));
+            for (int off = 0; off < clen; off += CHARACTERIZE_ONLINE_CHUNK) {
+                int len = (clen - off < CHARACTERIZE_ONLINE_CHUNK) ? clen - off : CHARACTERIZE_ONLINE_CHUNK;
+                cs642OnlineFeed(&est, &ciphertext[off], len);
+                memset(online_key, 0, sizeof(online_key));
+                keylen = cs642OnlineQuery(&est, online_key, &confidence);
+                if (memcmp(online_key, last_key, sizeof(online_key)) != 0) {
+                    memcpy(last_key, online_key, sizeof(last_key));
+                    settled = off + len;
+                }
+            }
+
+            // The whole sample, solved at once
+            memset(plaintext, 0, clen + 1);
+            memset(solver_key, 0, sizeof(solver_key));
+            cs642PerformCryptanalysis(cipher, ciphertext, clen, plaintext, clen, solver_key);
+            if (cs642CheckPlaintext(cipher, plaintext, ciphertext, solver_key)) {
+                logMessage(LOG_ERROR_LEVEL, "The %s solver failed on a sample", cs642CipherStrings[cipher]);
+                result = -1;
+            }
+            if (keylen > 0 && memcmp(online_key, solver_key, keylen) == 0 &&
+                (cipher != CIPHER_VIGE || solver_key[keylen] == '\0')) {
+                agreed++;
+            } else {
+                logMessage(LOG_ERROR_LEVEL, "Online %s key differs from the solver's after %d bytes",
+                           cs642CipherStrings[cipher], clen);
+                result = -1;
+            }
+            converged += settled;
+            sample_bytes += clen;
+
+            free(plaintext);
+            free(ciphertext);
+        }
+
+        fprintf(out, "%s,%d,%.4f,%.1f,%.1f\n", cs642CipherStrings[cipher], trials,
+                (double)agreed / trials, converged / trials, sample_bytes / trials);
+        fflush(out);
+    }
+    return result;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// Function     : cs642ParseLengths
+// Description  : Parse a comma separated list of plaintext lengths
+//
+// Inputs       : list - the list (e.g. "50,100,200")
+//                lengths - the place to put the lengths
+//                max_lengths - the room in lengths
+// Outputs      : the number of lengths, -1 if the list is bad
+
+int cs642ParseLengths(const char *list, int *lengths, int max_lengths) {
+    int count = 0;
+    const char *p = list;
+
+    while (*p != '\0') {
+        char *end;
+        long len = strtol(p, &end, 10);
+        if (end == p || len <= 0 || len > 1000000 || count == max_lengths) {
+            return -1;
+        }
+        lengths[count++] = (int)len;
+        p = end;
+        if (*p == ',') {
+            p++;
+        } else if (*p != '\0') {
+            return -1;
+        }
+    }
+    return (count > 0) ? count : -1;
+}
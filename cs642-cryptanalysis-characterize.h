@@ -0,0 +1,57 @@
+#ifndef CS642_CRYPTANALYSIS_CHARACTERIZE_INCLUDED
+#define CS642_CRYPTANALYSIS_CHARACTERIZE_INCLUDED
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  File           : cs642-cryptanalysis-characterize.h
+//  Description    : This is an include file for the accuracy-vs-length
+//                   characterization of the cryptanalysis solvers, and the
+//                   check of the online key estimator against them.
+//
+//   Author        : Max Mitchell
+//   Last Modified : October 19th, 2026
+//
+
+// Include Files
+#include <stdio.h>
+
+//
+// Defines
+
+#define CS642_CHARACTERIZE_MAX_LENGTHS 32
+#define CS642_CHARACTERIZE_DEFAULT_LENGTHS "25,50,100,200,300,500,800,1200"
+
+//
+// Functions
+
+int cs642CharacterizeSolvers(int trials, const int *lengths, int num_lengths,
+                             int word_keys, FILE *out);
+// Run trials of every solver at each plaintext length and write one CSV row
+// per cipher and length (key recovery rate, partial key accuracy, plaintext
+// recovery rate and time per trial). With word_keys the Vigenere keys are
+// 6-11 letter corpus words instead of random letters
+
+int cs642CharacterizeVigenereFamily(int trials, const int *lengths,
+                                    int num_lengths, int word_keys, FILE *out);
+// Run trials of the Vigenere family solver under each sign convention at each
+// plaintext length and write one CSV row per variant and length (variant
+// detection rate, key recovery rate, partial key accuracy, plaintext recovery
+// rate and time per trial). Variant Beaufort counts as detected when it is
+// reported as its Vigenere equivalent (the negated key)
+
+int cs642CharacterizeAlphabet(int trials, const int *lengths, int num_lengths,
+                              int size, FILE *out);
+// Run trials of the Affine solver over the alphabet of size symbols (26, 36,
+// 56 or 66) at each plaintext length and write one CSV row per length (key
+// recovery rate, plaintext recovery rate and time per trial)
+
+int cs642CheckOnlineEstimator(int trials, FILE *out);
+// Feed trials project samples of each cipher the online estimator supports to
+// it in chunks and check the converged key against the full solver's, writing
+// one CSV row per cipher (agreement rate, mean bytes until the key settled and
+// mean sample size). Returns 0 if every key matched, -1 if not
+
+int cs642ParseLengths(const char *list, int *lengths, int max_lengths);
+// Parse a comma separated list of lengths, returns the count (-1 if bad)
+
+#endif
@@ -0,0 +1,619 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+//  File           : cs642-cryptanalysis-corpus.c
+//  Description    : This is the memory-mapped text corpus for the cs642
+//                   cryptanalysis project. The file is mapped read-only and
+//                   tokenized into a table of word views on first use, so
+//                   nothing is read until a word index actually needs it and
+//                   the text itself is never copied onto the heap. When a
+//                   current snapshot (written by cs642CorpusWriteSnapshot) is
+//                   next to the corpus, its word table, hash slots and
+//                   trigram model are mapped as they are and nothing is
+//                   tokenized, so startup and resident memory no longer grow
+//                   with the size of the corpus text.
+//
+//   Author        : Max Mitchell
+//   Last Modified : October 19th, 2026
+//
+
+// Include Files
+#include <compsci642_log.h>
+#include <ctype.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Project Include Files
+#include "cs642-cryptanalysis-support.h"
+#include "cs642-cryptanalysis-corpus.h"
+#include "cs642-cryptanalysis-ngram.h"
+
+// Defines
+#define CORPUS_INITIAL_SLOTS 4096
+#define CORPUS_MAX_PATH 4096
+#define CORPUS_SNAPSHOT_MAGIC "CS642SN1"
+#define CORPUS_TRIGRAMS (NGRAM_SYMBOLS * NGRAM_SYMBOLS * NGRAM_SYMBOLS)
+
+// Distinct word, stored as an offset into the mapping
+typedef struct {
+    uint32_t offset; // Offset of the first occurrence
+    uint32_t length; // Number of letters
+    int count;       // Number of occurrences
+} CorpusEntry;
+
+// Snapshot file header, followed by the word table, the hash slots, the
+// trigram model and the word text (every section 4-byte aligned)
+typedef struct {
+    char magic[8];          // CORPUS_SNAPSHOT_MAGIC
+    uint64_t corpus_size;   // Size of the corpus it was built from
+    int64_t corpus_mtime;   // Modification time of that corpus
+    uint32_t num_words;     // Entries in the word table
+    uint32_t num_slots;     // Hash slots (a power of 2)
+    uint32_t num_trigrams;  // Trigram log10 probabilities
+    uint32_t text_bytes;    // Bytes of word text
+    float trigram_mean;     // Mean trigram log10 probability
+    uint32_t reserved;
+} CorpusSnapshotHeader;
+
+// Global Data
+
+const char *corpus_text = NULL; // Mapped corpus file
+size_t corpus_length = 0;       // Length of the mapping
+int64_t corpus_mtime = 0;       // Modification time of the corpus file
+char corpus_path[CORPUS_MAX_PATH];
+int corpus_tokenized = 0;       // Word table built (or mapped)
+int corpus_failed = 0;          // Loading failed, do not retry (or log) again
+
+const char *corpus_word_text = NULL; // Base of the word offsets
+
+void *corpus_snapshot = NULL; // Mapped snapshot, NULL if tokenized
+size_t corpus_snapshot_length = 0;
+const float *corpus_snapshot_trigrams = NULL;
+float corpus_snapshot_trigram_mean = 0.0f;
+
+CorpusEntry *corpus_words = NULL; // Distinct words, in order of appearance
+int corpus_num_words = 0;
+int corpus_words_allocated = 0;
+
+int *corpus_slots = NULL; // Open addressing hash table of word indices
+int corpus_num_slots = 0;
+
+//
+// Functions
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// Function     : corpusHash
+// Description  : Helper function to hash a word view, ignoring case
+//
+// Inputs       : word - the word view
+//                wlen - the length of the word
+// Outputs      : the hash value
+
+uint32_t corpusHash(const char *word, int wlen) {
+    uint32_t hash = 2166136261u;
+
+    // FNV-1a
+    for (int i = 0; i < wlen; i++) {
+        hash ^= (uint8_t)toupper(word[i]);
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// Function     : corpusSameWord
+// Description  : Helper function to compare a table entry with a word view
+//
+// Inputs       : entry - the table entry
+//                word - the word view
+//                wlen - the length of the word
+// Outputs      : 1 if the same word (ignoring case), 0 otherwise
+
+int corpusSameWord(CorpusEntry *entry, const char *word, int wlen) {
+    if ((int)entry->length != wlen) {
+        return 0;
+    }
+    return strncasecmp(corpus_word_text + entry->offset, word, wlen) == 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// Function     : corpusGrowSlots
+// Description  : Helper function to double the hash table and rehash
+//
+// Inputs       : void
+// Outputs      : 0 if successful, -1 if failure
+
+int corpusGrowSlots(void) {
+    int num_slots = (corpus_num_slots == 0) ? CORPUS_INITIAL_SLOTS : corpus_num_slots * 2;
+    int *slots = (int *)malloc(num_slots * sizeof(int));
+    if (slots == NULL) {
+        return -1;
+    }
+    memset(slots, 0xff, num_slots * sizeof(int));
+
+    for (int i = 0; i < corpus_num_words; i++) {
+        CorpusEntry *entry = &corpus_words[i];
+        uint32_t s = corpusHash(corpus_word_text + entry->offset, entry->length) & (num_slots - 1);
+        while (slots[s] != -1) {
+            s = (s + 1) & (num_slots - 1);
+        }
+        slots[s] = i;
+    }
+
+    free(corpus_slots);
+    corpus_slots = slots;
+    corpus_num_slots = num_slots;
+    return 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// Function     : corpusAddWord
+// Description  : Helper function to count one occurrence of a word
+//
+// Inputs       : offset - the offset of the word in the mapping
+//                wlen - the length of the word
+// Outputs      : 0 if successful, -1 if failure
+
+int corpusAddWord(size_t offset, int wlen) {
+    const char *word = corpus_text + offset;
+
+    // Keep the table at most half full
+    if (2 * (corpus_num_words + 1) > corpus_num_slots && corpusGrowSlots()) {
+        return -1;
+    }
+
+    uint32_t s = corpusHash(word, wlen) & (corpus_num_slots - 1);
+    while (corpus_slots[s] != -1) {
+        if (corpusSameWord(&corpus_words[corpus_slots[s]], word, wlen)) {
+            corpus_words[corpus_slots[s]].count++;
+            return 0;
+        }
+        s = (s + 1) & (corpus_num_slots - 1);
+    }
+
+    // New word
+    if (corpus_num_words == corpus_words_allocated) {
+        int allocated = (corpus_words_allocated == 0) ? CORPUS_INITIAL_SLOTS / 2 : corpus_words_allocated * 2;
+        CorpusEntry *words = (CorpusEntry *)realloc(corpus_words, allocated * sizeof(CorpusEntry));
+        if (words == NULL) {
+            return -1;
+        }
+        corpus_words = words;
+        corpus_words_allocated = allocated;
+    }
+    corpus_words[corpus_num_words].offset = (uint32_t)offset;
+    corpus_words[corpus_num_words].length = (uint32_t)wlen;
+    corpus_words[corpus_num_words].count = 1;
+    corpus_slots[s] = corpus_num_words++;
+    return 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// Function     : corpusTokenize
+// Description  : Helper function to build the word table from the mapping.
+//                Words are maximal runs of ASCII letters, as in the project
+//                dictionary.
+//
+// Inputs       : void
+// Outputs      : 0 if successful, -1 if failure
+
+int corpusTokenize(void) {
+    size_t i = 0;
+
+    corpus_word_text = corpus_text;
+    madvise((void *)corpus_text, corpus_length, MADV_SEQUENTIAL);
+    while (i < corpus_length) {
+        while (i < corpus_length && !isalpha((uint8_t)corpus_text[i])) {
+            i++;
+        }
+        size_t start = i;
+        while (i < corpus_length && isalpha((uint8_t)corpus_text[i])) {
+            i++;
+        }
+        if (i > start && corpusAddWord(start, (int)(i - start))) {
+            return -1;
+        }
+    }
+    madvise((void *)corpus_text, corpus_length, MADV_RANDOM);
+
+    corpus_tokenized = 1;
+    logMessage(CipherVerboseLevel, "Tokenized corpus [%zu bytes], [%d] unique words.",
+               corpus_length, corpus_num_words);
+    return 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// Function     : corpusCheckSnapshot
+// Description  : Helper function to check the word table and hash slots of a
+//                snapshot, so a damaged file cannot send a lookup outside the
+//                mapping (or round the slots forever)
+//
+// Inputs       : header - the snapshot header (sizes already checked)
+//                words - the word table
+//                slots - the hash slots
+//                text - the word text
+// Outputs      : 0 if good, -1 if not
+
+int corpusCheckSnapshot(const CorpusSnapshotHeader *header, const CorpusEntry *words,
+                        const int *slots, const char *text) {
+    for (uint32_t i = 0; i < header->num_words; i++) {
+        if (words[i].length == 0 ||
+            (uint64_t)words[i].offset + words[i].length > header->text_bytes) {
+            return -1;
+        }
+    }
+
+    // Every word in exactly one slot, found from its hash, and the rest empty
+    uint32_t used = 0;
+    for (uint32_t s = 0; s < header->num_slots; s++) {
+        if (slots[s] == -1) {
+            continue;
+        }
+        if (slots[s] < 0 || (uint32_t)slots[s] >= header->num_words) {
+            return -1;
+        }
+        used++;
+    }
+    if (used != header->num_words) {
+        return -1;
+    }
+    for (uint32_t i = 0; i < header->num_words; i++) {
+        uint32_t s = corpusHash(text + words[i].offset, words[i].length) & (header->num_slots - 1);
+        while (slots[s] != -1 && (uint32_t)slots[s] != i) {
+            s = (s + 1) & (header->num_slots - 1);
+        }
+        if (slots[s] == -1) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// Function     : corpusLoadSnapshot
+// Description  : Helper function to map the snapshot of the corpus, if there
+//                is one and it was built from the mapped corpus file
+//
+// Inputs       : void
+// Outputs      : 0 if the snapshot is in use, -1 otherwise
+
+int corpusLoadSnapshot(void) {
+    char path[CORPUS_MAX_PATH + sizeof(CS642_CORPUS_SNAPSHOT_SUFFIX)];
+    struct stat st;
+
+    snprintf(path, sizeof(path), "%s%s", corpus_path, CS642_CORPUS_SNAPSHOT_SUFFIX);
+    int fd = open(path, O_RDONLY);
+    if (fd == -1) {
+        return -1; // No snapshot
+    }
+    if (fstat(fd, &st) == -1 || (size_t)st.st_size < sizeof(CorpusSnapshotHeader)) {
+        close(fd);
+        return -1;
+    }
+    void *snapshot = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (snapshot == MAP_FAILED) {
+        return -1;
+    }
+
+    // It must match the corpus and the sections must fill the file exactly
+    const CorpusSnapshotHeader *header = (const CorpusSnapshotHeader *)snapshot;
+    size_t expected = sizeof(CorpusSnapshotHeader) +
+                      (size_t)header->num_words * sizeof(CorpusEntry) +
+                      (size_t)header->num_slots * sizeof(int) +
+                      (size_t)header->num_trigrams * sizeof(float) + header->text_bytes;
+    if (memcmp(header->magic, CORPUS_SNAPSHOT_MAGIC, sizeof(header->magic)) != 0 ||
+        header->corpus_size != corpus_length || header->corpus_mtime != corpus_mtime ||
+        header->num_trigrams != CORPUS_TRIGRAMS || header->num_slots == 0 ||
+        (header->num_slots & (header->num_slots - 1)) != 0 ||
+        header->num_words >= header->num_slots || expected != (size_t)st.st_size) {
+        logMessage(CipherVerboseLevel, "Ignoring stale or bad corpus snapshot %s", path);
+        munmap(snapshot, st.st_size);
+        return -1;
+    }
+
+    const char *section = (const char *)snapshot + sizeof(CorpusSnapshotHeader);
+    const CorpusEntry *words = (const CorpusEntry *)section;
+    section += header->num_words * sizeof(CorpusEntry);
+    const int *slots = (const int *)section;
+    section += header->num_slots * sizeof(int);
+    const float *trigrams = (const float *)section;
+    section += header->num_trigrams * sizeof(float);
+    if (corpusCheckSnapshot(header, words, slots, section)) {
+        logMessage(LOG_WARNING_LEVEL, "Ignoring damaged corpus snapshot %s", path);
+        munmap(snapshot, st.st_size);
+        return -1;
+    }
+
+    corpus_words = (CorpusEntry *)words;
+    corpus_slots = (int *)slots;
+    corpus_snapshot_trigrams = trigrams;
+    corpus_word_text = section;
+
+    corpus_num_words = header->num_words;
+    corpus_words_allocated = header->num_words;
+    corpus_num_slots = header->num_slots;
+    corpus_snapshot_trigram_mean = header->trigram_mean;
+    corpus_snapshot = snapshot;
+    corpus_snapshot_length = st.st_size;
+    corpus_tokenized = 1;
+    logMessage(CipherVerboseLevel, "Mapped corpus snapshot %s, [%d] unique words.",
+               path, corpus_num_words);
+    return 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// Function     : corpusReady
+// Description  : Helper function to map (default file) and tokenize the
+//                corpus on first use, or map its snapshot instead. A failure
+//                is remembered until the corpus is released, so the callers
+//                (one per word checked) fail fast after the first error.
+//
+// Inputs       : void
+// Outputs      : 0 if successful, -1 if failure
+
+int corpusReady(void) {
+    if (corpus_failed) {
+        return -1;
+    }
+    if ((corpus_text == NULL && cs642CorpusLoad(CS642_CORPUS_FILE)) ||
+        (!corpus_tokenized && corpusLoadSnapshot() && corpusTokenize())) {
+        corpus_failed = 1;
+        return -1;
+    }
+    return 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// Function     : cs642CorpusLoad
+// Description  : Map a corpus file; the words are tokenized on first access
+//
+// Inputs       : path - the corpus file
+// Outputs      : 0 if successful, -1 if failure
+
+int cs642CorpusLoad(const char *path) {
+    struct stat st;
+
+    cs642CorpusRelease();
+
+    int fd = open(path, O_RDONLY);
+    if (fd == -1) {
+        logMessage(LOG_ERROR_LEVEL, "Failed to open corpus file %s", path);
+        return -1;
+    }
+    if (fstat(fd, &st) == -1 || st.st_size == 0 || st.st_size > UINT32_MAX) {
+        logMessage(LOG_ERROR_LEVEL, "Bad corpus file %s", path);
+        close(fd);
+        return -1;
+    }
+
+    // The mapping stays valid after the descriptor is closed
+    void *text = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (text == MAP_FAILED) {
+        logMessage(LOG_ERROR_LEVEL, "Failed to map corpus file %s", path);
+        return -1;
+    }
+
+    corpus_text = (const char *)text;
+    corpus_length = st.st_size;
+    corpus_mtime = st.st_mtime;
+    snprintf(corpus_path, sizeof(corpus_path), "%s", path);
+    return 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// Function     : cs642CorpusSize
+// Description  : Get the number of distinct words in the corpus
+//
+// Inputs       : void
+// Outputs      : the number of words, -1 if the corpus cannot be loaded
+
+int cs642CorpusSize(void) {
+    if (corpusReady()) {
+        return -1;
+    }
+    return corpus_num_words;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// Function     : cs642CorpusGetWord
+// Description  : Get a word from the corpus (by its index)
+//
+// Inputs       : idx - the index of the word
+// Outputs      : the word view (NULL word if out of range)
+
+CorpusWord cs642CorpusGetWord(int idx) {
+    CorpusWord word = {NULL, 0, 0};
+
+    if (corpusReady() == 0 && idx >= 0 && idx < corpus_num_words) {
+        word.word = corpus_word_text + corpus_words[idx].offset;
+        word.length = corpus_words[idx].length;
+        word.count = corpus_words[idx].count;
+    }
+    return word;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// Function     : cs642CorpusFindWord
+// Description  : Look up a word in the corpus
+//
+// Inputs       : word - the word (either case, need not be NUL terminated)
+//                wlen - the length of the word
+// Outputs      : the number of times it appears, 0 if it does not
+
+int cs642CorpusFindWord(const char *word, int wlen) {
+    if (corpusReady() || wlen <= 0) {
+        return 0;
+    }
+
+    uint32_t s = corpusHash(word, wlen) & (corpus_num_slots - 1);
+    while (corpus_slots[s] != -1) {
+        if (corpusSameWord(&corpus_words[corpus_slots[s]], word, wlen)) {
+            return corpus_words[corpus_slots[s]].count;
+        }
+        s = (s + 1) & (corpus_num_slots - 1);
+    }
+    return 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// Function     : cs642CorpusText
+// Description  : Get the raw corpus text (mapping the default file if needed)
+//
+// Inputs       : length - the place to put the text length in
+// Outputs      : the mapped text (not NUL terminated), NULL if not loaded
+
+const char *cs642CorpusText(size_t *length) {
+    if (corpus_failed) {
+        return NULL;
+    }
+    if (corpus_text == NULL && cs642CorpusLoad(CS642_CORPUS_FILE)) {
+        corpus_failed = 1;
+        return NULL;
+    }
+    *length = corpus_length;
+    return corpus_text;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// Function     : cs642CorpusSnapshotTrigrams
+// Description  : Get the trigram model stored in the corpus snapshot
+//
+// Inputs       : mean - the place to put the mean log10 probability in
+// Outputs      : the trigram table, NULL if no snapshot is in use
+
+const float *cs642CorpusSnapshotTrigrams(float *mean) {
+    if (corpusReady() || corpus_snapshot == NULL) {
+        return NULL;
+    }
+    *mean = corpus_snapshot_trigram_mean;
+    return corpus_snapshot_trigrams;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// Function     : cs642CorpusWriteSnapshot
+// Description  : Write the snapshot of the word table (with its hash slots,
+//                the word text packed behind them) and a trigram model next
+//                to the corpus file
+//
+// Inputs       : trigrams - the trigram log10 probabilities
+//                mean - the mean trigram log10 probability
+// Outputs      : 0 if successful, -1 if failure
+
+int cs642CorpusWriteSnapshot(const float *trigrams, float mean) {
+    char path[CORPUS_MAX_PATH + sizeof(CS642_CORPUS_SNAPSHOT_SUFFIX)];
+    char tmp_path[sizeof(path) + 4];
+    CorpusSnapshotHeader header;
+
+    if (corpusReady() || trigrams == NULL) {
+        return -1;
+    }
+
+    // Entries point into the packed word text, padded to 4 bytes
+    CorpusEntry *entries = (CorpusEntry *)malloc((corpus_num_words + 1) * sizeof(CorpusEntry));
+    if (entries == NULL) {
+        return -1;
+    }
+    uint32_t text_bytes = 0;
+    for (int i = 0; i < corpus_num_words; i++) {
+        entries[i] = corpus_words[i];
+        entries[i].offset = text_bytes;
+        text_bytes += corpus_words[i].length;
+    }
+    uint32_t padding = (4 - text_bytes % 4) % 4;
+
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, CORPUS_SNAPSHOT_MAGIC, sizeof(header.magic));
+    header.corpus_size = corpus_length;
+    header.corpus_mtime = corpus_mtime;
+    header.num_words = corpus_num_words;
+    header.num_slots = corpus_num_slots;
+    header.num_trigrams = CORPUS_TRIGRAMS;
+    header.text_bytes = text_bytes + padding;
+    header.trigram_mean = mean;
+
+    snprintf(path, sizeof(path), "%s%s", corpus_path, CS642_CORPUS_SNAPSHOT_SUFFIX);
+    snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", path);
+    FILE *out = fopen(tmp_path, "w");
+    if (out == NULL) {
+        logMessage(LOG_ERROR_LEVEL, "Failed to create corpus snapshot %s", tmp_path);
+        free(entries);
+        return -1;
+    }
+    fwrite(&header, sizeof(header), 1, out);
+    fwrite(entries, sizeof(CorpusEntry), corpus_num_words, out);
+    fwrite(corpus_slots, sizeof(int), corpus_num_slots, out);
+    fwrite(trigrams, sizeof(float), CORPUS_TRIGRAMS, out);
+    for (int i = 0; i < corpus_num_words; i++) {
+        fwrite(corpus_word_text + corpus_words[i].offset, 1, corpus_words[i].length, out);
+    }
+    fwrite("\0\0\0", 1, padding, out);
+    free(entries);
+
+    // Move it into place only when complete
+    int failed = ferror(out);
+    if (fclose(out) || failed || rename(tmp_path, path)) {
+        logMessage(LOG_ERROR_LEVEL, "Failed to write corpus snapshot %s", path);
+        unlink(tmp_path);
+        return -1;
+    }
+    logMessage(LOG_OUTPUT_LEVEL, "Wrote corpus snapshot %s, [%d] unique words.", path,
+               corpus_num_words);
+    return 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// Function     : cs642CorpusRelease
+// Description  : Unmap the corpus and free the word table (a later use tries
+//                to load it again)
+//
+// Inputs       : void
+// Outputs      : void
+
+void cs642CorpusRelease(void) {
+    if (corpus_text != NULL) {
+        munmap((void *)corpus_text, corpus_length);
+        corpus_text = NULL;
+        corpus_length = 0;
+    }
+    if (corpus_snapshot != NULL) {
+        // The tables live in the snapshot mapping
+        munmap(corpus_snapshot, corpus_snapshot_length);
+        corpus_snapshot = NULL;
+        corpus_snapshot_length = 0;
+        corpus_snapshot_trigrams = NULL;
+    } else {
+        free(corpus_words);
+        free(corpus_slots);
+    }
+    corpus_words = NULL;
+    corpus_num_words = 0;
+    corpus_words_allocated = 0;
+    corpus_slots = NULL;
+    corpus_word_text = NULL;
+    corpus_num_slots = 0;
+    corpus_tokenized = 0;
+    corpus_failed = 0;
+}
@@ -0,0 +1,66 @@
+#ifndef CS642_CRYPTANALYSIS_CORPUS_INCLUDED
+#define CS642_CRYPTANALYSIS_CORPUS_INCLUDED
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  File           : cs642-cryptanalysis-corpus.h
+//  Description    : This is an include file for the memory-mapped text corpus
+//                   used to build the cryptanalysis word indexes. The corpus
+//                   file is mapped read-only and tokenized on first use; words
+//                   are views into the mapping rather than copied strings.
+//                   A snapshot of the word table and trigram model
+//                   (<corpus>.snap) is mapped instead when it is current, so
+//                   startup does not scan the text at all.
+//
+//   Author        : Max Mitchell
+//   Last Modified : October 19th, 2026
+//
+
+// Include Files
+#include <stddef.h>
+#include <stdint.h>
+
+//
+// Defines
+
+#define CS642_CORPUS_FILE "pg11.txt"
+#define CS642_CORPUS_SNAPSHOT_SUFFIX ".snap"
+
+//
+// Type definitions
+
+// A distinct corpus word (not NUL terminated, case as in the first occurrence)
+typedef struct {
+    const char *word; // View into the mapped corpus
+    int length;       // Number of letters in the word
+    int count;        // Number of times it appears in the corpus
+} CorpusWord;
+
+//
+// Functions
+
+int cs642CorpusLoad(const char *path);
+// Map a corpus file (the words are tokenized lazily, on first access)
+
+int cs642CorpusSize(void);
+// Get the number of distinct words in the corpus, -1 if it cannot be loaded
+
+CorpusWord cs642CorpusGetWord(int idx);
+// Get a word from the corpus (by its index)
+
+int cs642CorpusFindWord(const char *word, int wlen);
+// Get the number of times a word (either case) appears, 0 if it does not
+
+const char *cs642CorpusText(size_t *length);
+// Get the raw corpus text (mapped, not NUL terminated), NULL if not loaded
+
+const float *cs642CorpusSnapshotTrigrams(float *mean);
+// Get the trigram model of the snapshot (and its mean), NULL if there is none
+
+int cs642CorpusWriteSnapshot(const float *trigrams, float mean);
+// Write the snapshot of the word table and the given trigram model
+
+void cs642CorpusRelease(void);
+// Unmap the corpus and free the word table
+
+#endif
@@ -18,9 +18,14 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <math.h>   
+#include <pthread.h>
+#include <unistd.h>
 
 // Project Include Files
 #include "cs642-cryptanalysis-support.h"
+#include "cs642-cryptanalysis-impl.h"
+#include "cs642-cryptanalysis-corpus.h"
+#include "cs642-cryptanalysis-ngram.h"
 
 // Global Assignment
 
@@ -33,6 +38,76 @@ double english_freq[26] = {
     2.758, 0.978, 2.360, 0.150, 1.974, 0.074
 };
 
+// Supported alphabets, A-Z followed by the symbol sets each one adds
+#define NUM_ALPHABETS 4
+#define ALPHABET_DIGITS 0x1
+#define ALPHABET_LATIN1 0x2
+#define ALPHABET_EXTRA_SHARE 1.0 // Percent of English text outside A-Z
+
+const int alphabet_contents[NUM_ALPHABETS] = {
+    0, ALPHABET_DIGITS, ALPHABET_LATIN1, ALPHABET_DIGITS | ALPHABET_LATIN1
+};
+cs642Alphabet alphabets[NUM_ALPHABETS];
+pthread_once_t alphabets_once = PTHREAD_ONCE_INIT;
+
+// Top-k key candidates for ROTX and AFFI
+#define AFFINE_TOP_K 5
+#define VERIFY_MIN_COVERAGE 0.75
+
+// A key from the statistical pass (ROT-X is a = 1)
+typedef struct {
+    double score; // Chi-squared, lower is better
+    int a;        // Multiplier
+    int b;        // Shift
+} KeyCandidate;
+
+// Pattern word (isomorph) index for the substitution cipher
+#define SUBS_MAX_WORD_LEN 24
+#define SUBS_MAX_NODES 500000
+#define SUBS_MAX_SKIPS 2        // Words that may be left out of a short text
+#define SUBS_SKIP_FRACTION 0.05 // ... and the share of a long text's words
+
+// All dictionary words sharing one letter pattern (e.g. "ABCA")
+typedef struct {
+    char pattern[SUBS_MAX_WORD_LEN + 1]; // Letter pattern of the words
+    int length;                          // Length of the pattern
+    int first;                           // First word in pattern_letters
+    int count;                           // Number of words in the group
+} PatternGroup;
+
+PatternGroup *pattern_groups = NULL;
+int num_pattern_groups = 0;
+uint8_t *pattern_letters = NULL; // Word letters (0-25), grouped by pattern
+
+// Dictionary-keyed Vigenere attack (keys are corpus words)
+#define VIGE_DICT_MIN_KEY 6
+#define VIGE_DICT_MAX_KEY 11
+#define VIGE_DICT_PREFIX 64          // Characters scored per key
+#define VIGE_DICT_MAX_THREADS 8
+#define VIGE_DICT_KEYS_PER_THREAD 256 // Fewer keys are not worth a thread
+#define VIGE_DICT_SLACK 1.0           // Per character allowance below English
+#define VIGE_DICT_GRACE 5.0           // Fixed allowance for the first trigrams
+
+// Joint refinement of the Vigenere key by trigram hill climbing
+#define VIGE_REFINE_MIN_PERIOD 3   // Shorter keys overlap within a trigram
+#define VIGE_REFINE_MAX_TEXT 1000  // Characters scored
+#define VIGE_REFINE_MAX_SWEEPS 10
+
+uint8_t *dict_keys = NULL;        // Key shifts (0-25), VIGE_DICT_MAX_KEY stride
+uint8_t *dict_key_lengths = NULL; // Key lengths
+int num_dict_keys = 0;
+
+// One thread's share of the dictionary keys
+typedef struct {
+    const int8_t *cipher; // Ciphertext prefix letters (0-25, -1 for a space)
+    int len;              // Length of the prefix
+    int first;            // First key to try
+    int last;             // One past the last key to try
+    double best_score;    // Best complete score found
+    int best_key;         // Key with that score (-1 if none)
+    long scored;          // Characters scored over all keys
+} VigeDictWork;
+
 //
 // Functions
 
@@ -40,21 +115,209 @@ double english_freq[26] = {
 
 ////////////////////////////////////////////////////////////////////////////////
 //
-// Function     : computeChiSquared
-// Description  : Helper function to compute the Chi-squared statistic
+// Alphabet kernels
 //
-// Inputs       : observed - the observed letter frequencies
-//                expected - the expected letter frequencies    
-//                clen - the length of the text
-// Outputs      : the computed Chi-squared statistic
+// The scoring and decryption kernels are written once as macro bodies over
+// the alphabet size N. Each common size gets its own instance in which N is a
+// compile-time constant (so the loops have fixed trip counts and the modular
+// steps fold away), and a generic instance takes N at run time.
+// getAlphabetKernels() picks the instance for a given size.
+
+// Chi-squared of a letter histogram decrypted under the affine key (a, b);
+// plaintext letter p was enciphered to (a * p + b) mod N. ROT-X is a = 1.
+#define CHI_SQ_AFFINE_BODY(N)                                                  \
+    double chi_sq_val = 0.0;                                                   \
+    for (int p = 0, c = b; p < (N); p++) {                                     \
+        double expected_count = expected[p] * total / 100.0;                   \
+        double diff = hist[c] - expected_count;                                \
+        chi_sq_val += diff * diff / expected_count;                            \
+        c += a;                                                                \
+        if (c >= (N)) {                                                        \
+            c -= (N);                                                          \
+        }                                                                      \
+    }                                                                          \
+    return chi_sq_val;
 
-double computeChiSq(double observed[], double expected[], int clen) {
-    double chi_sq_val = 0.0;
-    for (int i = 0; i < 26; i++) {
-        double expected_count = expected[i] * clen / 100.0;
-        chi_sq_val += ((observed[i] - expected_count) * (observed[i] - expected_count)) / expected_count;
+// Decryption table for the affine key (a, b): table[c] = plaintext letter
+#define AFFINE_TABLE_BODY(N)                                                   \
+    for (int p = 0, c = b; p < (N); p++) {                                     \
+        table[c] = (uint8_t)p;                                                 \
+        c += a;                                                                \
+        if (c >= (N)) {                                                        \
+            c -= (N);                                                          \
+        }                                                                      \
     }
-    return chi_sq_val;
+
+#define DEFINE_ALPHABET_KERNELS(SUFFIX, N)                                     \
+    double chiSqAffine##SUFFIX(int n, const int *hist, const double *expected, \
+                               int total, int a, int b) {                      \
+        CHI_SQ_AFFINE_BODY(N)                                                  \
+    }                                                                          \
+    void affineTable##SUFFIX(int n, int a, int b, uint8_t *table) {            \
+        AFFINE_TABLE_BODY(N)                                                   \
+    }
+
+DEFINE_ALPHABET_KERNELS(26, 26)          // English letters
+DEFINE_ALPHABET_KERNELS(36, 36)          // Letters and digits
+DEFINE_ALPHABET_KERNELS(56, 56)          // English and Latin-1 letters
+DEFINE_ALPHABET_KERNELS(Generic, n)      // Any other size
+
+// Kernel dispatch table, the generic entry (size 0) must be last
+typedef struct {
+    int size;
+    double (*chi_sq_affine)(int n, const int *hist, const double *expected,
+                            int total, int a, int b);
+    void (*affine_table)(int n, int a, int b, uint8_t *table);
+} AlphabetKernels;
+
+const AlphabetKernels alphabet_kernels[] = {
+    {26, chiSqAffine26, affineTable26},
+    {36, chiSqAffine36, affineTable36},
+    {56, chiSqAffine56, affineTable56},
+    {0, chiSqAffineGeneric, affineTableGeneric},
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// Function     : getAlphabetKernels
+// Description  : Helper function to find the kernels for an alphabet size
+//
+// Inputs       : n - the number of letters in the alphabet
+// Outputs      : the specialized kernels, or the generic ones
+
+const AlphabetKernels *getAlphabetKernels(int n) {
+    const AlphabetKernels *k = alphabet_kernels;
+    while (k->size != 0 && k->size != n) {
+        k++;
+    }
+    return k;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// Function     : addAlphabetSymbol
+// Description  : Helper function to append a symbol (and its lowercase form,
+//                if it has one) to an alphabet being built
+//
+// Inputs       : alpha - the alphabet
+//                upper - the symbol
+//                lower - its lowercase form, 0 if none
+// Outputs      : void
+
+void addAlphabetSymbol(cs642Alphabet *alpha, uint8_t upper, uint8_t lower) {
+    alpha->symbols[alpha->size] = (char)upper;
+    alpha->index[upper] = (int8_t)alpha->size;
+    if (lower != 0) {
+        alpha->index[lower] = (int8_t)alpha->size;
+    }
+    alpha->size++;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// Function     : buildAlphabets
+// Description  : Helper function to build the supported alphabets. English
+//                plaintext keeps its letter frequencies, scaled so that the
+//                symbols beyond A-Z share ALPHABET_EXTRA_SHARE percent.
+//
+// Inputs       : void
+// Outputs      : void
+
+void buildAlphabets(void) {
+    for (int i = 0; i < NUM_ALPHABETS; i++) {
+        cs642Alphabet *alpha = &alphabets[i];
+
+        memset(alpha->index, -1, sizeof(alpha->index));
+        alpha->size = 0;
+        for (int l = 0; l < 26; l++) {
+            addAlphabetSymbol(alpha, 'A' + l, 'a' + l);
+        }
+        if (alphabet_contents[i] & ALPHABET_DIGITS) {
+            for (int d = 0; d < 10; d++) {
+                addAlphabetSymbol(alpha, '0' + d, 0);
+            }
+        }
+        if (alphabet_contents[i] & ALPHABET_LATIN1) {
+            // 0xC0-0xDE, less the multiplication sign, with lowercase 0x20 up
+            for (int ch = 0xC0; ch <= 0xDE; ch++) {
+                if (ch != 0xD7) {
+                    addAlphabetSymbol(alpha, ch, ch + 0x20);
+                }
+            }
+        }
+
+        // Expected frequencies
+        int extra = alpha->size - 26;
+        double scale = (extra > 0) ? (100.0 - ALPHABET_EXTRA_SHARE) / 100.0 : 1.0;
+        for (int s = 0; s < alpha->size; s++) {
+            alpha->expected[s] = (s < 26) ? english_freq[s] * scale : ALPHABET_EXTRA_SHARE / extra;
+        }
+
+        const AlphabetKernels *kernels = getAlphabetKernels(alpha->size);
+        alpha->chi_sq_affine = kernels->chi_sq_affine;
+        alpha->affine_table = kernels->affine_table;
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// Function     : cs642GetAlphabet
+// Description  : Get the alphabet of a size (built on first use)
+//
+// Inputs       : size - the number of symbols
+// Outputs      : the alphabet, NULL if there is none of that size
+
+const cs642Alphabet *cs642GetAlphabet(int size) {
+    pthread_once(&alphabets_once, buildAlphabets);
+    for (int i = 0; i < NUM_ALPHABETS; i++) {
+        if (alphabets[i].size == size) {
+            return &alphabets[i];
+        }
+    }
+    return NULL;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// Function     : chiSqAffine
+// Description  : Helper function to compute the Chi-squared statistic of a
+//                histogram decrypted under the affine key (a, b), with the
+//                kernel of the alphabet size
+//
+// Inputs       : alpha - the alphabet
+//                hist - the ciphertext symbol counts
+//                total - the number of symbols
+//                a - the 'a' value of the key
+//                b - the 'b' value of the key
+// Outputs      : the Chi-squared statistic
+
+double chiSqAffine(const cs642Alphabet *alpha, const int *hist, int total, int a, int b) {
+    return alpha->chi_sq_affine(alpha->size, hist, alpha->expected, total, a, b);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// Function     : letterHistogram
+// Description  : Helper function to count the symbols of a text
+//
+// Inputs       : alpha - the alphabet
+//                text - the text to analyze
+//                tlen - the length of the text
+//                hist - the place to put the counts (alpha->size entries)
+// Outputs      : the number of symbols counted
+
+int letterHistogram(const cs642Alphabet *alpha, const char *text, int tlen, int *hist) {
+    int total = 0;
+
+    memset(hist, 0, alpha->size * sizeof(int));
+    for (int i = 0; i < tlen; i++) {
+        int s = alpha->index[(uint8_t)text[i]];
+        if (s >= 0) {
+            hist[s]++;
+            total++;
+        }
+    }
+    return total;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -76,39 +339,129 @@ int inverseMod(int a, int mod) {
     return -1; 
 }
 
+////////////////////////////////////////////////////////////////////////////////
+//
+// Function     : affineMultipliers
+// Description  : Helper function to list the valid Affine 'a' values (those
+//                invertible modulo the alphabet size)
+//
+// Inputs       : n - the number of letters in the alphabet
+//                values - the place to put the values (n entries)
+// Outputs      : the number of values
+
+int affineMultipliers(int n, int *values) {
+    int count = 0;
+    for (int a = 1; a < n; a++) {
+        if (inverseMod(a, n) != -1) {
+            values[count++] = a;
+        }
+    }
+    return count;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// Function     : checkPlaintextBuffer
+// Description  : Helper function to grow the global plaintext buffer
+//
+// Inputs       : size - the number of chars needed
+// Outputs      : 0 if successful, -1 if failure
+
+int checkPlaintextBuffer(int size) {
+    if (size > buffer_size) {
+        char *temp_buffer = realloc(global_plaintext_buffer, size * sizeof(char));
+        if (temp_buffer == NULL) {
+            return -1;
+        }
+        global_plaintext_buffer = temp_buffer;
+        buffer_size = size;
+    }
+    return 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// Function     : pushCandidate
+// Description  : Helper function to keep the k lowest-scoring keys in a
+//                fixed-size max-heap (root is the worst kept key)
+//
+// Inputs       : heap - the heap
+//                count - the number of keys in the heap (updated)
+//                k - the heap capacity
+//                cand - the key to offer
+// Outputs      : void
+
+void pushCandidate(KeyCandidate *heap, int *count, int k, KeyCandidate cand) {
+    int i;
+
+    if (*count < k) {
+        // Sift up
+        i = (*count)++;
+        while (i > 0 && heap[(i - 1) / 2].score < cand.score) {
+            heap[i] = heap[(i - 1) / 2];
+            i = (i - 1) / 2;
+        }
+        heap[i] = cand;
+        return;
+    }
+    if (cand.score >= heap[0].score) {
+        return;
+    }
+
+    // Replace the root and sift down
+    i = 0;
+    for (;;) {
+        int child = 2 * i + 1;
+        if (child >= *count) {
+            break;
+        }
+        if (child + 1 < *count && heap[child + 1].score > heap[child].score) {
+            child++;
+        }
+        if (heap[child].score <= cand.score) {
+            break;
+        }
+        heap[i] = heap[child];
+        i = child;
+    }
+    heap[i] = cand;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// Function     : compareCandidates
+// Description  : qsort comparator ordering keys by score (best first)
+//
+// Inputs       : a, b - pointers to the candidates
+// Outputs      : <0, 0, >0
+
+int compareCandidates(const void *a, const void *b) {
+    double sa = ((const KeyCandidate *)a)->score;
+    double sb = ((const KeyCandidate *)b)->score;
+    return (sa > sb) - (sa < sb);
+}
 
 ////////////////////////////////////////////////////////////////////////////////
 //
 // Function     : decryptAffine
-// Description  : Helper function to decrypt an Affine cipher
+// Description  : Helper function to decrypt an Affine cipher (ROT-X is a = 1)
 //
-// Inputs       : ciphertext - the ciphertext to decrypt
+// Inputs       : alpha - the alphabet
+//                ciphertext - the ciphertext to decrypt
 //                clen - the length of the ciphertext
-//                plaintext - the place to put the plaintext in
+//                plaintext - the place to put the plaintext in (clen + 1)
 //                a - the 'a' value of the Affine cipher
 //                b - the 'b' value of the Affine cipher
 // Outputs      : void
 
-// Helped to make the execution of the Affine cipher more efficient !
-void decryptAffine(char *ciphertext, int clen, char *plaintext, int a, int b) {
-    int a_i = inverseMod(a, 26);
-    if (a_i == -1) {
-        // Error checking
-        return;
-    }
+void decryptAffine(const cs642Alphabet *alpha, char *ciphertext, int clen,
+                   char *plaintext, int a, int b) {
+    uint8_t table[CS642_ALPHABET_MAX];
 
+    alpha->affine_table(alpha->size, a, b, table);
     for (int i = 0; i < clen; i++) {
-        if (isalpha(ciphertext[i])) {
-            char base = islower(ciphertext[i]) ? 'a' : 'A';
-            int y = ciphertext[i] - base;
-            int x = (a_i * (y - b + 26)) % 26;
-
-            if (i < clen) {
-                plaintext[i] = x + base;
-            }
-        } else if (i < clen) {
-            plaintext[i] = ciphertext[i];
-        }
+        int c = alpha->index[(uint8_t)ciphertext[i]];
+        plaintext[i] = (c >= 0) ? alpha->symbols[table[c]] : ciphertext[i];
     }
     // Null Terminate
     plaintext[clen] = '\0';
@@ -116,46 +469,99 @@ void decryptAffine(char *ciphertext, int clen, char *plaintext, int a, int b) {
 
 ////////////////////////////////////////////////////////////////////////////////
 //
-// Function     : findBestCaesarShift
-// Description  : Helper function to find the best Caesar shift for a group
+// Function     : encryptAffine
+// Description  : Encrypt with an Affine key over an alphabet
 //
-// Inputs       : group - the group to analyze
-//                group_length - the length of the group
-// Outputs      : the best Caesar shift
+// Inputs       : alpha - the alphabet
+//                plaintext - the plaintext to encrypt
+//                len - the length of the plaintext
+//                ciphertext - the place to put the ciphertext in (len + 1)
+//                a - the 'a' value of the Affine cipher
+//                b - the 'b' value of the Affine cipher
+// Outputs      : void
 
-char findBestCaesarShift(char *group, int group_length) {
-    // Initialize variables in this scope
-    double best_chi_squared = 1e10;
-    int best_shift = 0;
-    
-    char decrypted_group[group_length + 1]; 
+void encryptAffine(const cs642Alphabet *alpha, const char *plaintext, int len,
+                   char *ciphertext, int a, int b) {
+    for (int i = 0; i < len; i++) {
+        int p = alpha->index[(uint8_t)plaintext[i]];
+        ciphertext[i] = (p >= 0) ? alpha->symbols[(a * p + b) % alpha->size] : plaintext[i];
+    }
+    // Null Terminate
+    ciphertext[len] = '\0';
+}
 
-    for (int shift = 0; shift < 26; shift++) {
-        cs642Decrypt(CIPHER_ROTX, (char *)&shift, sizeof(shift), decrypted_group, group_length, group, group_length);
+////////////////////////////////////////////////////////////////////////////////
+//
+// Function     : wordCoverage
+// Description  : Helper function to measure how much of a text is made of
+//                corpus words
+//
+// Inputs       : text - the text to check
+//                tlen - the length of the text
+// Outputs      : the fraction of letters inside corpus words
 
-        // Null terminate
-        decrypted_group[group_length] = '\0';
+double wordCoverage(const char *text, int tlen) {
+    int covered = 0, total = 0;
 
-        // Calculate frequency
-        double observed_freq[26] = {0};
-        for (int i = 0; i < group_length; i++) {
-            if (isalpha(decrypted_group[i])) {
-                char base = islower(decrypted_group[i]) ? 'a' : 'A';
-                observed_freq[decrypted_group[i] - base]++;
+    for (int i = 0; i < tlen;) {
+        while (i < tlen && !isalpha(text[i])) {
+            i++;
+        }
+        int start = i;
+        while (i < tlen && isalpha(text[i])) {
+            i++;
+        }
+        if (i > start) {
+            total += i - start;
+            if (cs642CorpusFindWord(&text[start], i - start) > 0) {
+                covered += i - start;
             }
         }
+    }
+    return (total > 0) ? (double)covered / total : 0.0;
+}
 
-        // Compute Chi-sq statistic
-        double chi_squared_val = computeChiSq(observed_freq, english_freq, group_length);
+////////////////////////////////////////////////////////////////////////////////
+//
+// Function     : verifyCandidates
+// Description  : Helper function to check the kept keys in score order and
+//                pick the first whose plaintext is mostly dictionary words
+//
+// Inputs       : alpha - the alphabet
+//                ciphertext - the ciphertext
+//                clen - the length of the ciphertext
+//                cands - the kept keys (sorted in place)
+//                count - the number of kept keys
+// Outputs      : the index of the chosen key (best coverage if none passes,
+//                the best scoring key if the text cannot be checked)
+
+int verifyCandidates(const cs642Alphabet *alpha, char *ciphertext, int clen,
+                     KeyCandidate *cands, int count) {
+    double best_coverage = -1.0;
+    int best = 0;
+
+    // Sort first, so index 0 is the best scoring key even if no check is run
+    qsort(cands, count, sizeof(KeyCandidate), compareCandidates);
+    if (checkPlaintextBuffer(clen + 1)) {
+        return 0;
+    }
 
-        // Update the best shift
-        if (chi_squared_val < best_chi_squared) {
-            best_chi_squared = chi_squared_val;
-            best_shift = shift;
+    for (int i = 0; i < count; i++) {
+        decryptAffine(alpha, ciphertext, clen, global_plaintext_buffer, cands[i].a, cands[i].b);
+        double coverage = wordCoverage(global_plaintext_buffer, clen);
+        if (coverage >= VERIFY_MIN_COVERAGE) {
+            if (i > 0) {
+                logMessage(CipherVerboseLevel, "Verified key rank %d (a=%d, b=%d), coverage %.2f",
+                           i + 1, cands[i].a, cands[i].b, coverage);
+            }
+            return i;
+        }
+        if (coverage > best_coverage) {
+            best_coverage = coverage;
+            best = i;
         }
     }
-
-    return (char)('A' + best_shift);
+    return best;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -202,7 +608,7 @@ double computeIC(char *text, int tlen) {
 // Outputs      : the estimated key length
 
 int estKeyLen(char *cText, int cLen) {
-    int maxLen = 20;
+    int maxLen = VIGE_MAX_PERIOD;
     double targetIC = 0.068;
     double minICDiff = 1e10;
     int bestLen = 1;
@@ -245,225 +651,1131 @@ int estKeyLen(char *cText, int cLen) {
     return bestLen;
 }
 
+////////////////////////////////////////////////////////////////////////////////
+//
+// Function     : computePattern
+// Description  : Helper function to compute the letter pattern of a word,
+//                e.g. "LETTER" -> "ABCCBD"
+//
+// Inputs       : word - the word (letters, either case)
+//                wlen - the length of the word
+//                pattern - the place to put the pattern (wlen + 1 chars)
+// Outputs      : 0 if successful, -1 if the word has a non-letter
+
+int computePattern(const char *word, int wlen, char *pattern) {
+    char seen[26];
+    char next = 'A';
+
+    memset(seen, 0, sizeof(seen));
+    for (int i = 0; i < wlen; i++) {
+        if (!isalpha((uint8_t)word[i])) {
+            return -1;
+        }
+        int l = toupper((uint8_t)word[i]) - 'A';
+        if (seen[l] == 0) {
+            seen[l] = next++;
+        }
+        pattern[i] = seen[l];
+    }
+    // Null Terminate
+    pattern[wlen] = '\0';
+    return 0;
+}
 
+////////////////////////////////////////////////////////////////////////////////
+//
+// Function     : freePatternIndex
+// Description  : Helper function to release the pattern index
+//
+// Inputs       : void
+// Outputs      : void
 
+void freePatternIndex(void) {
+    free(pattern_groups);
+    pattern_groups = NULL;
+    free(pattern_letters);
+    pattern_letters = NULL;
+    num_pattern_groups = 0;
+}
 
-// Given functions
-
+// Corpus word with its pattern, used while building the index
+typedef struct {
+    char pattern[SUBS_MAX_WORD_LEN + 1];
+    CorpusWord word;
+} PatternEntry;
 
 ////////////////////////////////////////////////////////////////////////////////
 //
-// Function     : cs642StudentInit
-// Description  : This is a function that is called before any cryptanalysis
-//                occurs. Use it if you need to initialize some datastructures
-//                you may be reusing across ciphers.
+// Function     : comparePatternEntries
+// Description  : qsort comparator ordering corpus words by pattern, then by
+//                corpus count (most frequent first)
 //
-// Inputs       : void
-// Outputs      : 0 if successful, -1 if failure
+// Inputs       : a, b - pointers to the pattern entries
+// Outputs      : <0, 0, >0 as for strcmp
 
-int cs642StudentInit(void) {
-
-    // General buffer for plaintext
+int comparePatternEntries(const void *a, const void *b) {
+    const PatternEntry *ea = (const PatternEntry *)a;
+    const PatternEntry *eb = (const PatternEntry *)b;
 
-    // Make sure to check buffer in each function !!! 
-    // Leading to errors
-    buffer_size = 1024;
-    global_plaintext_buffer = (char *)malloc(buffer_size * sizeof(char));
-    
-    if (global_plaintext_buffer == NULL) {
-        return -1;
+    int cmp = strcmp(ea->pattern, eb->pattern);
+    if (cmp != 0) {
+        return cmp;
     }
-
-    return 0;
+    return eb->word.count - ea->word.count;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 //
-// Function     : cs642PerformROTXCryptanalysis
-// Description  : This is the function to cryptanalyze the ROT X cipher
+// Function     : buildPatternIndex
+// Description  : Helper function to index the corpus words by letter pattern
 //
-// Inputs       : ciphertext - the ciphertext to analyze
-//                clen - the length of the ciphertext
-//                plaintext - the place to put the plaintext in
-//                plen - the length of the plaintext
-//                key - the place to put the key in
+// Inputs       : void
 // Outputs      : 0 if successful, -1 if failure
 
-int cs642PerformROTXCryptanalysis(char *ciphertext, int clen, char *plaintext,
-                                  int plen, uint8_t *key) {
+int buildPatternIndex(void) {
+    int corpus_size = cs642CorpusSize();
+    int num_words = 0;
 
-    // Check buffer
-    if (clen > buffer_size) {
-        char *temp_buffer = realloc(global_plaintext_buffer, (clen + 1) * sizeof(char));
-        global_plaintext_buffer = temp_buffer;
-        buffer_size = clen + 1;
+    if (corpus_size < 0) {
+        return -1;
     }
 
-    // Initialize variables
-    double best_chi_squared = 1e10;
-    int best_key = 0;
-
-    // Try all possible keys
-    for (int i = 0; i < 26; i++) {
-        // Use the provided cs642Decrypt
-        cs642Decrypt(CIPHER_ROTX, (char *)&i, sizeof(i), global_plaintext_buffer, clen, ciphertext, clen);
-
-        // Calculate frequency
-        double observed_freq[26] = {0};
-        for (int j = 0; j < clen; j++) {
-            if (isalpha(global_plaintext_buffer[j])) {
-                char base = islower(global_plaintext_buffer[j]) ? 'a' : 'A';
-                observed_freq[global_plaintext_buffer[j] - base]++;
-            }
+    // Collect the words that fit a pattern
+    PatternEntry *entries = (PatternEntry *)malloc((corpus_size + 1) * sizeof(PatternEntry));
+    if (entries == NULL) {
+        return -1;
+    }
+    for (int i = 0; i < corpus_size; i++) {
+        CorpusWord word = cs642CorpusGetWord(i);
+        if (word.length <= SUBS_MAX_WORD_LEN &&
+            computePattern(word.word, word.length, entries[num_words].pattern) == 0) {
+            entries[num_words].word = word;
+            num_words++;
         }
+    }
+    qsort(entries, num_words, sizeof(PatternEntry), comparePatternEntries);
+
+    // Worst case is one group per word
+    pattern_groups = (PatternGroup *)malloc((num_words + 1) * sizeof(PatternGroup));
+    pattern_letters = (uint8_t *)malloc((num_words + 1) * SUBS_MAX_WORD_LEN);
+    if (pattern_groups == NULL || pattern_letters == NULL) {
+        free(entries);
+        freePatternIndex();
+        return -1;
+    }
 
-        // Compute Chi-sq statistic
-        double chi_squared = computeChiSq(observed_freq, english_freq, clen);
-
-        // Find the best key
-        if (chi_squared < best_chi_squared) {
-            best_chi_squared = chi_squared;
-            best_key = i;
-            strncpy(plaintext, global_plaintext_buffer, plen); 
+    // Copy out the letters, opening a new group when the pattern changes
+    num_pattern_groups = 0;
+    for (int i = 0; i < num_words; i++) {
+        CorpusWord *word = &entries[i].word;
+
+        if (num_pattern_groups == 0 ||
+            strcmp(pattern_groups[num_pattern_groups - 1].pattern, entries[i].pattern) != 0) {
+            PatternGroup *grp = &pattern_groups[num_pattern_groups++];
+            strcpy(grp->pattern, entries[i].pattern);
+            grp->length = word->length;
+            grp->first = i;
+            grp->count = 0;
+        }
+        pattern_groups[num_pattern_groups - 1].count++;
+        for (int j = 0; j < word->length; j++) {
+            pattern_letters[i * SUBS_MAX_WORD_LEN + j] = toupper(word->word[j]) - 'A';
         }
     }
 
-    *key = (uint8_t)best_key;
-
+    free(entries);
     return 0;
 }
 
+////////////////////////////////////////////////////////////////////////////////
+//
+// Function     : findPatternGroup
+// Description  : Helper function to look up the group for a letter pattern
+//
+// Inputs       : pattern - the pattern to look up
+// Outputs      : the group index, or -1 if no dictionary word has the pattern
+
+int findPatternGroup(const char *pattern) {
+    int lo = 0, hi = num_pattern_groups - 1;
+
+    // Groups are sorted by pattern, so binary search
+    while (lo <= hi) {
+        int mid = (lo + hi) / 2;
+        int cmp = strcmp(pattern_groups[mid].pattern, pattern);
+        if (cmp == 0) {
+            return mid;
+        } else if (cmp < 0) {
+            lo = mid + 1;
+        } else {
+            hi = mid - 1;
+        }
+    }
+    return -1;
+}
 
+// One distinct ciphertext word in the substitution search
+typedef struct {
+    uint8_t letters[SUBS_MAX_WORD_LEN]; // Cipher letters (0-25)
+    int length;                         // Word length
+    int group;                          // Pattern group of the word
+    int resolved;                       // Assigned (or skipped) in search
+} SubsWord;
+
+// Search state for the substitution solver
+typedef struct {
+    SubsWord *words;     // Distinct ciphertext words
+    int num_words;       // Number of words
+    int map[26];         // Cipher letter -> plain letter, -1 if unknown
+    uint32_t used;       // Bitset of plain letters already assigned
+    uint32_t domain[26]; // Bitset of plain letters per cipher letter
+    int prune;           // Narrow the domains from word candidates
+    long nodes;          // Search nodes evaluated
+    int placed;          // Words given a dictionary word on this path
+    int best_placed;     // Most words placed on any path so far
+    int best_map[26];    // The mapping that placed them
+} SubsSolver;
 
 ////////////////////////////////////////////////////////////////////////////////
 //
-// Function     : cs642PerformAFFICryptanalysis
-// Description  : This is the function to cryptanalyze the Affine cipher
+// Function     : subsCandidateFits
+// Description  : Helper function to check a dictionary word against the
+//                current partial key
 //
-// Inputs       : ciphertext - the ciphertext to analyze
-//                clen - the length of the ciphertext
-//                plaintext - the place to put the plaintext in
-//                plen - the length of the plaintext
-//                key - the place to put the key in (8-bit packed value)
-// Outputs      : 0 if successful, -1 if failure
+// Inputs       : s - the solver state
+//                w - the ciphertext word
+//                cand - the candidate plaintext letters
+// Outputs      : 1 if the candidate is consistent, 0 otherwise
+
+int subsCandidateFits(SubsSolver *s, SubsWord *w, const uint8_t *cand) {
+    // Same pattern, so letters inside the word are already consistent
+    for (int i = 0; i < w->length; i++) {
+        int c = w->letters[i];
+        uint32_t bit = 1u << cand[i];
+        if (s->map[c] >= 0) {
+            if (s->map[c] != cand[i]) {
+                return 0;
+            }
+        } else if ((s->used & bit) || !(s->domain[c] & bit)) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+////////////////////////////////////////////////////////////////////////////////
 //
-int cs642PerformAFFICryptanalysis(char *ciphertext, int clen, char *plaintext, int plen, uint8_t *key) {
-    // Check buffer
-    if (clen > buffer_size) {
-        char *temp_buffer = realloc(global_plaintext_buffer, (clen + 1) * sizeof(char));
-        global_plaintext_buffer = temp_buffer;
-        buffer_size = clen + 1;
+// Function     : subsSearch
+// Description  : Helper function to solve the substitution key by constraint
+//                propagation and backtracking over the ciphertext words,
+//                always branching on the word with the fewest candidates
+//
+// Inputs       : s - the solver state
+//                skips - the number of words that may still be left out
+// Outputs      : 1 if solved, 0 if no solution, -1 if out of budget
+
+int subsSearch(SubsSolver *s, int skips) {
+    int best_word = -1, best_count = 0;
+    uint32_t narrowed[26];
+
+    if (++s->nodes > SUBS_MAX_NODES) {
+        return -1;
     }
 
-    // List of possible a
-    int possible_a_values[] = {1, 3, 5, 7, 9, 11, 15, 17, 19, 21, 23, 25};
-    int num_a_values = sizeof(possible_a_values) / sizeof(possible_a_values[0]);
+    // Keep the mapping that fits the most words, in case nothing fits them all
+    if (s->placed > s->best_placed) {
+        s->best_placed = s->placed;
+        memcpy(s->best_map, s->map, sizeof(s->best_map));
+    }
 
-    double best_chi_squared = 1e10;
-    int best_a_index = 0, best_b = 0;
+    // Count the candidates of each open word and narrow the letter domains
+    memcpy(narrowed, s->domain, sizeof(narrowed));
+    for (int i = 0; i < s->num_words; i++) {
+        SubsWord *w = &s->words[i];
+        PatternGroup *grp = &pattern_groups[w->group];
+        uint32_t seen[SUBS_MAX_WORD_LEN] = {0};
+        int count = 0;
 
-    // Try all combinations of 'a' and 'b'
-    for (int i = 0; i < num_a_values; i++) {
-        int a = possible_a_values[i];
-        for (int b = 0; b < 26; b++) {
-            // Need own helper for this particular decryption
-            decryptAffine(ciphertext, clen, global_plaintext_buffer, a, b);
-
-            // Calculate letter frequencies in the decrypted text
-            double observed_freq[26] = {0};
-            for (int j = 0; j < clen; j++) {
-                if (isalpha(global_plaintext_buffer[j])) {
-                    char base = islower(global_plaintext_buffer[j]) ? 'a' : 'A';
-                    observed_freq[global_plaintext_buffer[j] - base]++;
+        if (w->resolved) {
+            continue;
+        }
+        for (int j = 0; j < grp->count; j++) {
+            const uint8_t *cand = &pattern_letters[(grp->first + j) * SUBS_MAX_WORD_LEN];
+            if (subsCandidateFits(s, w, cand)) {
+                for (int k = 0; k < w->length; k++) {
+                    seen[k] |= 1u << cand[k];
                 }
+                count++;
             }
-
-            // Compute the Chi-sq statistic
-            double chi_squared = computeChiSq(observed_freq, english_freq, clen);
-
-            // Update the best key
-            if (chi_squared < best_chi_squared) {
-                best_chi_squared = chi_squared;
-                best_a_index = i;
-                best_b = b;
-                strncpy(plaintext, global_plaintext_buffer, plen); 
+        }
+        if (s->prune) {
+            for (int k = 0; k < w->length; k++) {
+                narrowed[w->letters[k]] &= seen[k];
             }
         }
+        if (best_word == -1 || count < best_count) {
+            best_word = i;
+            best_count = count;
+        }
     }
 
-    // Assign a and b
-    key[0] = (uint8_t)possible_a_values[best_a_index];  
-    key[1] = (uint8_t)best_b; 
+    // Every word placed, done
+    if (best_word == -1) {
+        return 1;
+    }
+
+    // An emptied domain is a dead end (unless the word can be skipped)
+    uint32_t saved_domain[26];
+    memcpy(saved_domain, s->domain, sizeof(saved_domain));
+    memcpy(s->domain, narrowed, sizeof(narrowed));
+    for (int c = 0; c < 26; c++) {
+        if (s->map[c] < 0 && s->domain[c] == 0) {
+            best_count = 0;
+        }
+    }
 
-    // Create a char array for the key
-    char aff_key[2] = {(char)key[0], (char)key[1]};
+    // Try each consistent candidate in corpus frequency order
+    SubsWord *w = &s->words[best_word];
+    PatternGroup *grp = &pattern_groups[w->group];
+    int saved_map[26];
+    uint32_t saved_used = s->used;
+    int result = 0;
+
+    memcpy(saved_map, s->map, sizeof(saved_map));
+    w->resolved = 1;
+    for (int j = 0; j < grp->count && best_count > 0 && result == 0; j++) {
+        const uint8_t *cand = &pattern_letters[(grp->first + j) * SUBS_MAX_WORD_LEN];
+        if (!subsCandidateFits(s, w, cand)) {
+            continue;
+        }
+        for (int k = 0; k < w->length; k++) {
+            s->map[w->letters[k]] = cand[k];
+            s->used |= 1u << cand[k];
+        }
+        s->placed++;
+        result = subsSearch(s, skips);
+        if (result != 1) {
+            s->placed--;
+        }
+        if (result == 0) {
+            memcpy(s->map, saved_map, sizeof(saved_map));
+            s->used = saved_used;
+        }
+    }
 
-    // Decrypt using cs642Decrypt
-    cs642Decrypt(CIPHER_AFFI, aff_key, sizeof(aff_key), plaintext, plen, ciphertext, clen);
+    // Leave the word out (truncated or out of dictionary)
+    if (result == 0 && skips > 0) {
+        memcpy(s->domain, saved_domain, sizeof(saved_domain));
+        result = subsSearch(s, skips - 1);
+    }
 
-    return 0;
+    if (result != 1) {
+        w->resolved = 0;
+        memcpy(s->map, saved_map, sizeof(saved_map));
+        s->used = saved_used;
+        memcpy(s->domain, saved_domain, sizeof(saved_domain));
+    }
+    return result;
 }
 
 
+
 ////////////////////////////////////////////////////////////////////////////////
 //
-// Function     : cs642PerformVIGECryptanalysis
-// Description  : This is the function to cryptanalyze the Vigenere cipher
+// Function     : scoreVigenereFamily
+// Description  : Helper function to find the best key of every Vigenere
+//                family variant from one set of column histograms
 //
 // Inputs       : ciphertext - the ciphertext to analyze
 //                clen - the length of the ciphertext
-//                plaintext - the place to put the plaintext in
-//                plen - the length of the plaintext
-//                key - the place to put the key in
-// Outputs      : 0 if successful, -1 if failure
+//                period - the key length
+//                keys - the place to put the key of each variant
+//                scores - the place to put the Chi-squared sum of each variant
+// Outputs      : void
 
-int cs642PerformVIGECryptanalysis(char *ciphertext, int clen, char *plaintext,
-                                  int plen, char *key) {
-    
-    // Estimate key
-    int estimated_key_length = estKeyLen(ciphertext, clen);
-    
-    // Memory allocation
-    char **caesar_groups = (char **)malloc(estimated_key_length * sizeof(char *));
-    for (int i = 0; i < estimated_key_length; i++) {
-        // Allocate enough space considering remainder
-        int group_size = (clen + estimated_key_length - 1) / estimated_key_length + 1;
-        caesar_groups[i] = (char *)malloc(group_size * sizeof(char));
+void scoreVigenereFamily(char *ciphertext, int clen, int period,
+                         char keys[VIGE_VARIANT_MAX][VIGE_MAX_PERIOD + 1],
+                         double scores[VIGE_VARIANT_MAX]) {
+    const cs642Alphabet *english = cs642GetAlphabet(26);
+    int hist[VIGE_MAX_PERIOD][26];
+    int totals[VIGE_MAX_PERIOD];
+
+    // Count every column in one pass (spaces still take a key position)
+    memset(hist, 0, sizeof(hist));
+    memset(totals, 0, sizeof(totals));
+    for (int i = 0, col = 0; i < clen; i++) {
+        if (isalpha(ciphertext[i])) {
+            hist[col][toupper(ciphertext[i]) - 'A']++;
+            totals[col]++;
+        }
+        if (++col == period) {
+            col = 0;
+        }
     }
 
-    // Group the ciphertext 
-    for (int i = 0; i < clen; i++) {
-        int group_index = i % estimated_key_length;
-        int position_in_group = i / estimated_key_length;
-        caesar_groups[group_index][position_in_group] = ciphertext[i];
+    for (int v = 0; v < VIGE_VARIANT_MAX; v++) {
+        scores[v] = 0.0;
     }
 
+    for (int col = 0; col < period; col++) {
+        double best_vige = 1e10, best_beau = 1e10;
+        int vige_shift = 0, beau_shift = 0;
+
+        // Vigenere: c = p + k. Beaufort: c = k - p, the reflected alphabet
+        for (int k = 0; k < 26; k++) {
+            double chi_vige = chiSqAffine(english, hist[col], totals[col], 1, k);
+            double chi_beau = chiSqAffine(english, hist[col], totals[col], 25, k);
+            if (chi_vige < best_vige) {
+                best_vige = chi_vige;
+                vige_shift = k;
+            }
+            if (chi_beau < best_beau) {
+                best_beau = chi_beau;
+                beau_shift = k;
+            }
+        }
+
+        // Variant Beaufort (c = p - k) is Vigenere under the negated key
+        keys[VIGE_VARIANT_VIGENERE][col] = 'A' + vige_shift;
+        keys[VIGE_VARIANT_BEAUFORT][col] = 'A' + beau_shift;
+        keys[VIGE_VARIANT_VARIANT_BEAUFORT][col] = 'A' + (26 - vige_shift) % 26;
+        scores[VIGE_VARIANT_VIGENERE] += best_vige;
+        scores[VIGE_VARIANT_BEAUFORT] += best_beau;
+        scores[VIGE_VARIANT_VARIANT_BEAUFORT] += best_vige;
+    }
+
+    // Null Terminate
+    for (int v = 0; v < VIGE_VARIANT_MAX; v++) {
+        keys[v][period] = '\0';
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// Function     : decryptVigenereFamily
+// Description  : Helper function to decrypt any Vigenere family variant
+//
+// Inputs       : ciphertext - the ciphertext to decrypt
+//                clen - the length of the ciphertext
+//                plaintext - the place to put the plaintext in
+//                plen - the length of the plaintext
+//                key - the key letters
+//                period - the key length
+//                variant - the sign convention
+// Outputs      : void
+
+void decryptVigenereFamily(char *ciphertext, int clen, char *plaintext, int plen,
+                           char *key, int period, cs642VigenereVariant variant) {
+    int len = (clen < plen) ? clen : plen;
+
+    for (int i = 0, col = 0; i < len; i++) {
+        if (isalpha(ciphertext[i])) {
+            int c = toupper(ciphertext[i]) - 'A';
+            int k = key[col] - 'A';
+            int p;
+            switch (variant) {
+            case VIGE_VARIANT_BEAUFORT:
+                p = k - c;
+                break;
+            case VIGE_VARIANT_VARIANT_BEAUFORT:
+                p = c + k;
+                break;
+            default:
+                p = c - k;
+                break;
+            }
+            plaintext[i] = 'A' + (p + 26) % 26;
+        } else {
+            plaintext[i] = ciphertext[i];
+        }
+        if (++col == period) {
+            col = 0;
+        }
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// Function     : shortestKeyPeriod
+// Description  : Helper function to reduce a key that repeats itself (the IC
+//                estimate can land on a multiple of the real key length)
+//
+// Inputs       : key - the key letters (terminated at the new length)
+//                period - the key length
+// Outputs      : the shortest period of the key
+
+int shortestKeyPeriod(char *key, int period) {
+    for (int d = 1; d < period; d++) {
+        if (period % d != 0) {
+            continue;
+        }
+        int i = d;
+        while (i < period && key[i] == key[i - d]) {
+            i++;
+        }
+        if (i == period) {
+            key[d] = '\0';
+            return d;
+        }
+    }
+    return period;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// Function     : copyVigenereKey
+// Description  : Helper function to copy a key into the caller's key buffer,
+//                which only has room for cs642GetCipherKeyLength() letters
+//
+// Inputs       : key - the place to put the key in
+//                letters - the key letters
+//                period - the key length
+// Outputs      : void
+
+void copyVigenereKey(char *key, const char *letters, int period) {
+    int max_len = cs642GetCipherKeyLength(CIPHER_VIGE);
+    int len = (period < max_len) ? period : max_len;
+
+    memcpy(key, letters, len);
     // Null Terminate
-    for (int i = 0; i < estimated_key_length; i++) {
-        int group_size = (clen + estimated_key_length - 1) / estimated_key_length;
-        caesar_groups[i][group_size] = '\0';
+    key[len] = '\0';
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// Function     : bestAffineShift
+// Description  : Helper function to find the best shift of a letter histogram
+//                for a fixed multiplier, and how clearly it beats the runner up
+//
+// Inputs       : hist - the letter counts
+//                total - the number of letters
+//                a - the multiplier (1 for shifts)
+//                margin - the place to put (second - best) / second in
+// Outputs      : the best shift
+
+int bestAffineShift(const int *hist, int total, int a, double *margin) {
+    const cs642Alphabet *english = cs642GetAlphabet(26);
+    double best = 1e10, second = 1e10;
+    int best_shift = 0;
+
+    for (int k = 0; k < 26; k++) {
+        double chi_squared = chiSqAffine(english, hist, total, a, k);
+        if (chi_squared < best) {
+            second = best;
+            best = chi_squared;
+            best_shift = k;
+        } else if (chi_squared < second) {
+            second = chi_squared;
+        }
     }
+    *margin = (total > 0 && second > 0.0) ? (second - best) / second : 0.0;
+    return best_shift;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// Function     : onlinePeriod
+// Description  : Helper function to pick the Vigenere period of a stream from
+//                the running column statistics (the rule of estKeyLen)
+//
+// Inputs       : est - the estimator
+// Outputs      : the estimated period
+
+int onlinePeriod(cs642OnlineEstimator *est) {
+    double targetIC = 0.068;
+    double minICDiff = 1e10;
+    int bestLen = 1;
+
+    for (int p = 1, base = 0; p <= VIGE_MAX_PERIOD; base += p, p++) {
+        double avgIC = 0.0;
+        for (int col = base; col < base + p; col++) {
+            int n = est->col_total[col];
+            if (n > 1) {
+                avgIC += (double)est->col_pairs[col] / ((double)n * (n - 1));
+            }
+        }
+        avgIC /= p;
+
+        double icDiff = fabs(avgIC - targetIC);
+        if (icDiff < minICDiff) {
+            minICDiff = icDiff;
+            bestLen = p;
+        }
+    }
+    return bestLen;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// Function     : refineColumnScore
+// Description  : Helper function to score the trigrams that touch one key
+//                column, with that column decrypted under a given shift
+//                (the neighbouring symbols are the current plaintext)
+//
+// Inputs       : cipher - the ciphertext letters (0-25, -1 for a space)
+//                sym - the current plaintext symbols
+//                len - the number of characters
+//                col - the key column
+//                period - the key length (at least VIGE_REFINE_MIN_PERIOD)
+//                shift - the shift to score the column under
+//                trigrams - the trigram log10 probabilities
+// Outputs      : the summed log10 probability of the touching trigrams
+
+double refineColumnScore(const int8_t *cipher, const uint8_t *sym, int len, int col,
+                         int period, int shift, const float *trigrams) {
+    double score = 0.0;
+
+    for (int i = col; i < len; i += period) {
+        if (cipher[i] < 0) {
+            continue; // Spaces do not depend on the key
+        }
+        int s = (cipher[i] - shift + 26) % 26;
+        int prev2 = (i >= 2) ? sym[i - 2] : 26;
+        int prev1 = (i >= 1) ? sym[i - 1] : 26;
+
+        // The three trigrams holding position i
+        score += trigrams[NGRAM_TRIGRAM(prev2, prev1, s)];
+        if (i + 1 < len) {
+            score += trigrams[NGRAM_TRIGRAM(prev1, s, sym[i + 1])];
+        }
+        if (i + 2 < len) {
+            score += trigrams[NGRAM_TRIGRAM(s, sym[i + 1], sym[i + 2])];
+        }
+    }
+    return score;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// Function     : refineVigenereKey
+// Description  : Helper function to improve a per-column Vigenere key by
+//                hill climbing over the key letters jointly. Each step tries
+//                every shift of one column, scored by the trigrams across it
+//                and its neighbouring columns, and keeps the best; a change
+//                only rescans that column, not the whole text.
+//
+// Inputs       : ciphertext - the ciphertext
+//                clen - the length of the ciphertext
+//                key - the key letters (improved in place)
+//                period - the key length
+// Outputs      : the number of key letters changed
+
+int refineVigenereKey(char *ciphertext, int clen, char *key, int period) {
+    const float *trigrams = cs642NgramTrigrams();
+    int len = (clen < VIGE_REFINE_MAX_TEXT) ? clen : VIGE_REFINE_MAX_TEXT;
+    int changed = 0, sweeps = 0, improved = 1;
+
+    if (period < VIGE_REFINE_MIN_PERIOD || trigrams == NULL || len == 0) {
+        return 0;
+    }
+    int8_t *cipher = (int8_t *)malloc(len);
+    uint8_t *sym = (uint8_t *)malloc(len);
+    if (cipher == NULL || sym == NULL) {
+        free(cipher);
+        free(sym);
+        return 0;
+    }
+
+    // Plaintext under the starting key
+    for (int i = 0, col = 0; i < len; i++) {
+        cipher[i] = isalpha(ciphertext[i]) ? toupper(ciphertext[i]) - 'A' : -1;
+        sym[i] = (cipher[i] < 0) ? 26 : (cipher[i] - (key[col] - 'A') + 26) % 26;
+        if (++col == period) {
+            col = 0;
+        }
+    }
+
+    while (improved && sweeps++ < VIGE_REFINE_MAX_SWEEPS) {
+        improved = 0;
+        for (int col = 0; col < period; col++) {
+            int shift = key[col] - 'A';
+            double current = refineColumnScore(cipher, sym, len, col, period, shift, trigrams);
+            double best = current;
+            int best_shift = shift;
+
+            for (int k = 0; k < 26; k++) {
+                if (k == shift) {
+                    continue;
+                }
+                double score = refineColumnScore(cipher, sym, len, col, period, k, trigrams);
+                if (score > best + 1e-9) {
+                    best = score;
+                    best_shift = k;
+                }
+            }
+            if (best_shift == shift) {
+                continue;
+            }
+
+            // Move the column to the better shift
+            key[col] = 'A' + best_shift;
+            for (int i = col; i < len; i += period) {
+                if (cipher[i] >= 0) {
+                    sym[i] = (cipher[i] - best_shift + 26) % 26;
+                }
+            }
+            changed++;
+            improved = 1;
+        }
+    }
+
+    free(cipher);
+    free(sym);
+    if (changed > 0) {
+        logMessage(CipherVerboseLevel, "VIGE refinement changed [%d] key letters in %d sweeps, key %.*s",
+                   changed, sweeps, period, key);
+    }
+    return changed;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// Function     : freeDictKeys
+// Description  : Helper function to free the dictionary key list
+//
+// Inputs       : void
+// Outputs      : void
+
+void freeDictKeys(void) {
+    free(dict_keys);
+    dict_keys = NULL;
+    free(dict_key_lengths);
+    dict_key_lengths = NULL;
+    num_dict_keys = 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// Function     : buildDictKeys
+// Description  : Helper function to collect the corpus words of a plausible
+//                Vigenere key length, as key shifts
+//
+// Inputs       : void
+// Outputs      : 0 if successful, -1 if failure
+
+int buildDictKeys(void) {
+    int num_words = cs642CorpusSize();
+    if (num_words < 0) {
+        return -1;
+    }
+
+    dict_keys = (uint8_t *)malloc(num_words * VIGE_DICT_MAX_KEY);
+    dict_key_lengths = (uint8_t *)malloc(num_words);
+    if (dict_keys == NULL || dict_key_lengths == NULL) {
+        freeDictKeys();
+        return -1;
+    }
+
+    for (int i = 0; i < num_words; i++) {
+        CorpusWord word = cs642CorpusGetWord(i);
+        if (word.length < VIGE_DICT_MIN_KEY || word.length > VIGE_DICT_MAX_KEY) {
+            continue;
+        }
+        for (int j = 0; j < word.length; j++) {
+            dict_keys[num_dict_keys * VIGE_DICT_MAX_KEY + j] = toupper(word.word[j]) - 'A';
+        }
+        dict_key_lengths[num_dict_keys++] = word.length;
+    }
+
+    logMessage(CipherVerboseLevel, "Built Vigenere dictionary key list [%d] keys", num_dict_keys);
+    return 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// Function     : vigeDictSearch
+// Description  : Thread body of the dictionary-keyed Vigenere attack. Each
+//                key decrypts the prefix one character at a time while the
+//                trigram score is summed, and is dropped as soon as the score
+//                falls below what English would reach (the running
+//                threshold), or can no longer beat the best key so far.
+//
+// Inputs       : arg - the thread's VigeDictWork
+// Outputs      : NULL
+
+void *vigeDictSearch(void *arg) {
+    VigeDictWork *work = (VigeDictWork *)arg;
+    const float *trigrams = cs642NgramTrigrams();
+    double floor_per_char = cs642NgramTrigramMean() - VIGE_DICT_SLACK;
+    float max_trigram = trigrams[0];
+
+    for (int t = 1; t < NGRAM_SYMBOLS * NGRAM_SYMBOLS * NGRAM_SYMBOLS; t++) {
+        if (trigrams[t] > max_trigram) {
+            max_trigram = trigrams[t];
+        }
+    }
+
+    work->best_score = -1e30;
+    work->best_key = -1;
+    work->scored = 0;
+    for (int k = work->first; k < work->last; k++) {
+        const uint8_t *key = &dict_keys[k * VIGE_DICT_MAX_KEY];
+        int period = dict_key_lengths[k];
+        double score = 0.0;
+        int a = 26, b = 26, i, col = 0;
+
+        for (i = 0; i < work->len; i++) {
+            int c = (work->cipher[i] < 0) ? 26 : (work->cipher[i] - key[col] + 26) % 26;
+            score += trigrams[NGRAM_TRIGRAM(a, b, c)];
+            a = b;
+            b = c;
+            if (++col == period) {
+                col = 0;
+            }
+
+            // Abort on the running threshold, or if even perfect trigrams
+            // from here on could not beat the best key
+            if (score < (i + 1) * floor_per_char - VIGE_DICT_GRACE ||
+                score + (work->len - i - 1) * max_trigram < work->best_score) {
+                break;
+            }
+        }
+        work->scored += (i < work->len) ? i + 1 : i;
+
+        if (i == work->len && score > work->best_score) {
+            work->best_score = score;
+            work->best_key = k;
+        }
+    }
+    return NULL;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// Function     : vigeDictionaryAttack
+// Description  : Helper function to try every dictionary word of a plausible
+//                length as the Vigenere key, split across threads
+//
+// Inputs       : ciphertext - the ciphertext to analyze
+//                clen - the length of the ciphertext
+//                key - the place to put the key letters (VIGE_DICT_MAX_KEY + 1)
+// Outputs      : the key length, 0 if no key passed the threshold
+
+int vigeDictionaryAttack(char *ciphertext, int clen, char *key) {
+    VigeDictWork work[VIGE_DICT_MAX_THREADS];
+    pthread_t threads[VIGE_DICT_MAX_THREADS];
+    int8_t cipher[VIGE_DICT_PREFIX];
+
+    if ((dict_keys == NULL && buildDictKeys()) || cs642NgramTrigrams() == NULL ||
+        num_dict_keys == 0) {
+        return 0;
+    }
+
+    // Only the prefix is ever scored
+    int len = (clen < VIGE_DICT_PREFIX) ? clen : VIGE_DICT_PREFIX;
+    for (int i = 0; i < len; i++) {
+        cipher[i] = isalpha(ciphertext[i]) ? toupper(ciphertext[i]) - 'A' : -1;
+    }
+
+    // One share of the keys per core
+    int num_threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    if (num_threads > num_dict_keys / VIGE_DICT_KEYS_PER_THREAD) {
+        num_threads = num_dict_keys / VIGE_DICT_KEYS_PER_THREAD;
+    }
+    if (num_threads > VIGE_DICT_MAX_THREADS) {
+        num_threads = VIGE_DICT_MAX_THREADS;
+    }
+    if (num_threads < 1) {
+        num_threads = 1;
+    }
+    for (int t = 0; t < num_threads; t++) {
+        work[t].cipher = cipher;
+        work[t].len = len;
+        work[t].first = (int)((long)num_dict_keys * t / num_threads);
+        work[t].last = (int)((long)num_dict_keys * (t + 1) / num_threads);
+    }
+
+    // The calling thread takes the first share
+    int started = 1;
+    while (started < num_threads &&
+           pthread_create(&threads[started], NULL, vigeDictSearch, &work[started]) == 0) {
+        started++;
+    }
+    vigeDictSearch(&work[0]);
+    for (int t = started; t < num_threads; t++) {
+        vigeDictSearch(&work[t]); // Could not start a thread, do it here
+    }
+    for (int t = 1; t < started; t++) {
+        pthread_join(threads[t], NULL);
+    }
+
+    int best = 0;
+    long scored = work[0].scored;
+    for (int t = 1; t < num_threads; t++) {
+        scored += work[t].scored;
+        if (work[t].best_score > work[best].best_score) {
+            best = t;
+        }
+    }
+    logMessage(CipherVerboseLevel, "VIGE dictionary attack: [%d] keys, %.1f chars scored per key, %d threads",
+               num_dict_keys, (double)scored / num_dict_keys, num_threads);
+
+    if (work[best].best_key < 0) {
+        return 0;
+    }
+    int period = dict_key_lengths[work[best].best_key];
+    for (int j = 0; j < period; j++) {
+        key[j] = 'A' + dict_keys[work[best].best_key * VIGE_DICT_MAX_KEY + j];
+    }
+    // Null Terminate
+    key[period] = '\0';
+    return period;
+}
+
+// Given functions
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// Function     : cs642StudentInit
+// Description  : This is a function that is called before any cryptanalysis
+//                occurs. Use it if you need to initialize some datastructures
+//                you may be reusing across ciphers.
+//
+// Inputs       : void
+// Outputs      : 0 if successful, -1 if failure
+
+int cs642StudentInit(void) {
+
+    // General buffer for plaintext
+
+    // Make sure to check buffer in each function !!! 
+    // Leading to errors
+    buffer_size = 1024;
+    global_plaintext_buffer = (char *)malloc(buffer_size * sizeof(char));
     
-    // Search for best shift
-    for (int i = 0; i < estimated_key_length; i++) {
-        key[i] = findBestCaesarShift(caesar_groups[i], (clen + estimated_key_length - 1) / estimated_key_length);
+    if (global_plaintext_buffer == NULL) {
+        return -1;
     }
+
+    return 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// Function     : cs642PerformROTXCryptanalysis
+// Description  : This is the function to cryptanalyze the ROT X cipher
+//
+// Inputs       : ciphertext - the ciphertext to analyze
+//                clen - the length of the ciphertext
+//                plaintext - the place to put the plaintext in
+//                plen - the length of the plaintext
+//                key - the place to put the key in
+// Outputs      : 0 if successful, -1 if failure
+
+int cs642PerformROTXCryptanalysis(char *ciphertext, int clen, char *plaintext,
+                                  int plen, uint8_t *key) {
+
+    // Initialize variables
+    const cs642Alphabet *english = cs642GetAlphabet(26);
+    KeyCandidate cands[AFFINE_TOP_K];
+    int num_cands = 0;
+    int hist[26];
+
+    // Letter counts of the ciphertext, each key just permutes them
+    int total = letterHistogram(english, ciphertext, clen, hist);
+
+    // Try all possible keys, keeping the best few
+    for (int i = 0; i < 26; i++) {
+        // Compute Chi-sq statistic
+        KeyCandidate cand = {chiSqAffine(english, hist, total, 1, i), 1, i};
+        pushCandidate(cands, &num_cands, AFFINE_TOP_K, cand);
+    }
+
+    // Check the kept keys against the dictionary
+    int best_key = cands[verifyCandidates(english, ciphertext, clen, cands, num_cands)].b;
+
+    // Use the provided cs642Decrypt
+    cs642Decrypt(CIPHER_ROTX, (char *)&best_key, sizeof(best_key), plaintext, plen, ciphertext, clen);
+
+    *key = (uint8_t)best_key;
+
+    return 0;
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// Function     : cs642PerformAFFICryptanalysis
+// Description  : This is the function to cryptanalyze the Affine cipher
+//
+// Inputs       : ciphertext - the ciphertext to analyze
+//                clen - the length of the ciphertext
+//                plaintext - the place to put the plaintext in
+//                plen - the length of the plaintext
+//                key - the place to put the key in (8-bit packed value)
+// Outputs      : 0 if successful, -1 if failure
+//
+int cs642PerformAFFICryptanalysis(char *ciphertext, int clen, char *plaintext, int plen, uint8_t *key) {
+    return cs642PerformAlphabetAFFICryptanalysis(cs642GetAlphabet(26), ciphertext, clen,
+                                                 plaintext, plen, key);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// Function     : cs642PerformAlphabetAFFICryptanalysis
+// Description  : This is the function to cryptanalyze the Affine cipher over
+//                any alphabet, with the kernels of its size
+//
+// Inputs       : alpha - the alphabet
+//                ciphertext - the ciphertext to analyze
+//                clen - the length of the ciphertext
+//                plaintext - the place to put the plaintext in
+//                plen - the length of the plaintext
+//                key - the place to put the key in (a, then b)
+// Outputs      : 0 if successful, -1 if failure
+
+int cs642PerformAlphabetAFFICryptanalysis(const cs642Alphabet *alpha,
+                                          char *ciphertext, int clen,
+                                          char *plaintext, int plen,
+                                          uint8_t *key) {
+    // List of possible a
+    int possible_a_values[CS642_ALPHABET_MAX];
+    int num_a_values = affineMultipliers(alpha->size, possible_a_values);
+
+    KeyCandidate cands[AFFINE_TOP_K];
+    int num_cands = 0;
+    int hist[CS642_ALPHABET_MAX];
+
+    // Letter counts of the ciphertext, each key just permutes them
+    int total = letterHistogram(alpha, ciphertext, clen, hist);
+
+    // Try all combinations of 'a' and 'b', keeping the best few
+    for (int i = 0; i < num_a_values; i++) {
+        int a = possible_a_values[i];
+        for (int b = 0; b < alpha->size; b++) {
+            // Compute the Chi-sq statistic
+            KeyCandidate cand = {chiSqAffine(alpha, hist, total, a, b), a, b};
+            pushCandidate(cands, &num_cands, AFFINE_TOP_K, cand);
+        }
+    }
+
+    // Check the kept keys against the dictionary
+    int best = verifyCandidates(alpha, ciphertext, clen, cands, num_cands);
+
+    // Assign a and b
+    key[0] = (uint8_t)cands[best].a;  
+    key[1] = (uint8_t)cands[best].b; 
+
+    if (alpha->size == 26) {
+        // Create a char array for the key
+        char aff_key[2] = {(char)key[0], (char)key[1]};
+
+        // Decrypt using cs642Decrypt
+        cs642Decrypt(CIPHER_AFFI, aff_key, sizeof(aff_key), plaintext, plen, ciphertext, clen);
+        return 0;
+    }
+
+    // The project only decrypts the 26 letter alphabet
+    if (checkPlaintextBuffer(clen + 1)) {
+        return -1;
+    }
+    decryptAffine(alpha, ciphertext, clen, global_plaintext_buffer, key[0], key[1]);
+    memcpy(plaintext, global_plaintext_buffer, (plen < clen) ? plen : clen);
+
+    return 0;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// Function     : cs642PerformVIGECryptanalysis
+// Description  : This is the function to cryptanalyze the Vigenere cipher
+//
+// Inputs       : ciphertext - the ciphertext to analyze
+//                clen - the length of the ciphertext
+//                plaintext - the place to put the plaintext in
+//                plen - the length of the plaintext
+//                key - the place to put the key in
+// Outputs      : 0 if successful, -1 if failure
+
+int cs642PerformVIGECryptanalysis(char *ciphertext, int clen, char *plaintext,
+                                  int plen, char *key) {
     
-    // Null Terminate
-    key[estimated_key_length] = '\0';
+    // Estimate key
+    int estimated_key_length = estKeyLen(ciphertext, clen);
     
-    // Use the cs642Decrypt function
-    cs642Decrypt(CIPHER_VIGE, key, estimated_key_length, plaintext, plen, ciphertext, clen);
+    // Best key per column from the shared column statistics
+    char keys[VIGE_VARIANT_MAX][VIGE_MAX_PERIOD + 1];
+    double scores[VIGE_VARIANT_MAX];
+    scoreVigenereFamily(ciphertext, clen, estimated_key_length, keys, scores);
+
+    // Fix the letters thin columns got wrong using the neighbouring columns
+    refineVigenereKey(ciphertext, clen, keys[VIGE_VARIANT_VIGENERE], estimated_key_length);
+    estimated_key_length = shortestKeyPeriod(keys[VIGE_VARIANT_VIGENERE], estimated_key_length);
     
-    // Free !!
-    for (int i = 0; i < estimated_key_length; i++) {
-        free(caesar_groups[i]);
+    // Use the cs642Decrypt function
+    cs642Decrypt(CIPHER_VIGE, keys[VIGE_VARIANT_VIGENERE], estimated_key_length, plaintext, plen, ciphertext, clen);
+    copyVigenereKey(key, keys[VIGE_VARIANT_VIGENERE], estimated_key_length);
+
+    // Column statistics are unreliable on short text, try word keys instead
+    int len = (clen < plen) ? clen : plen;
+    double coverage = wordCoverage(plaintext, len);
+    if (coverage < VERIFY_MIN_COVERAGE) {
+        char dict_key[VIGE_DICT_MAX_KEY + 1];
+        int period = vigeDictionaryAttack(ciphertext, clen, dict_key);
+        if (period > 0 && checkPlaintextBuffer(clen + 1) == 0) {
+            cs642Decrypt(CIPHER_VIGE, dict_key, period, global_plaintext_buffer, clen, ciphertext, clen);
+            double dict_coverage = wordCoverage(global_plaintext_buffer, len);
+            logMessage(CipherVerboseLevel, "VIGE key %s coverage %.2f, dictionary key %s coverage %.2f",
+                       keys[VIGE_VARIANT_VIGENERE], coverage, dict_key, dict_coverage);
+            if (dict_coverage > coverage) {
+                memcpy(plaintext, global_plaintext_buffer, len);
+                copyVigenereKey(key, dict_key, period);
+            }
+        }
     }
-    free(caesar_groups);
     
     return 0;
 }
 
+////////////////////////////////////////////////////////////////////////////////
+//
+// Function     : cs642PerformVIGEFamilyCryptanalysis
+// Description  : This is the function to cryptanalyze a Vigenere family
+//                cipher (Vigenere, Beaufort or variant Beaufort). The column
+//                histograms are computed once and every variant is scored
+//                from them.
+//
+// Inputs       : ciphertext - the ciphertext to analyze
+//                clen - the length of the ciphertext
+//                plaintext - the place to put the plaintext in
+//                plen - the length of the plaintext
+//                key - the place to put the key in
+//                variant - the place to put the best fitting variant in
+// Outputs      : 0 if successful, -1 if failure
+//
+// Note: Vigenere and variant Beaufort are the same cipher under negated keys,
+//       so they always score alike and variant Beaufort is never reported;
+//       its ciphertexts come back as Vigenere under the negated key.
+
+int cs642PerformVIGEFamilyCryptanalysis(char *ciphertext, int clen,
+                                        char *plaintext, int plen, char *key,
+                                        cs642VigenereVariant *variant) {
+
+    // The period is the same for all variants (the IC ignores the sign)
+    int period = estKeyLen(ciphertext, clen);
+
+    char keys[VIGE_VARIANT_MAX][VIGE_MAX_PERIOD + 1];
+    double scores[VIGE_VARIANT_MAX];
+    scoreVigenereFamily(ciphertext, clen, period, keys, scores);
+
+    // Pick the better fitting variant (variant Beaufort ties with Vigenere)
+    cs642VigenereVariant best = VIGE_VARIANT_VIGENERE;
+    if (scores[VIGE_VARIANT_BEAUFORT] < scores[VIGE_VARIANT_VIGENERE]) {
+        best = VIGE_VARIANT_BEAUFORT;
+    }
+    logMessage(CipherVerboseLevel, "VIGE family scores: Vigenere %.1f, Beaufort %.1f",
+               scores[VIGE_VARIANT_VIGENERE], scores[VIGE_VARIANT_BEAUFORT]);
+
+    period = shortestKeyPeriod(keys[best], period);
+    *variant = best;
+    decryptVigenereFamily(ciphertext, clen, plaintext, plen, keys[best], period, best);
+    copyVigenereKey(key, keys[best], period);
+
+    return 0;
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 //
 // Function     : cs642PerformSUBSCryptanalysis
@@ -474,15 +1786,287 @@ int cs642PerformVIGECryptanalysis(char *ciphertext, int clen, char *plaintext,
 //                plaintext - the place to put the plaintext in
 //                plen - the length of the plaintext
 //                key - the place to put the key in
-// Outputs      : 0 if successful, -1 if failure
+// Outputs      : 0 if successful, -1 if no key fits every word (the key and
+//                plaintext are then from the mapping that fit the most)
 
 int cs642PerformSUBSCryptanalysis(char *ciphertext, int clen, char *plaintext,
                                   int plen, char *key) {
 
-  // ADD CODE HERE
-    // No time to finish this one with the midterm tomorrow!
-  // Return successfully
-  return (0);
+    SubsSolver solver;
+    int result = 0;
+
+    // Pattern index is built on first use
+    if (pattern_groups == NULL && buildPatternIndex()) {
+        return -1;
+    }
+
+    // Collect the distinct ciphertext words that have a dictionary pattern
+    solver.words = (SubsWord *)malloc((clen / 2 + 1) * sizeof(SubsWord));
+    if (solver.words == NULL) {
+        return -1;
+    }
+    solver.num_words = 0;
+    for (int i = 0; i < clen;) {
+        int start = i;
+        while (i < clen && isalpha((uint8_t)ciphertext[i])) {
+            i++;
+        }
+        int wlen = i - start;
+        i++;
+        if (wlen == 0 || wlen > SUBS_MAX_WORD_LEN) {
+            continue;
+        }
+
+        // Words are runs of letters, anything else separates them
+        char pattern[SUBS_MAX_WORD_LEN + 1];
+        if (computePattern(&ciphertext[start], wlen, pattern)) {
+            continue;
+        }
+        int group = findPatternGroup(pattern);
+        if (group == -1) {
+            continue;
+        }
+
+        SubsWord *w = &solver.words[solver.num_words];
+        w->length = wlen;
+        w->group = group;
+        w->resolved = 0;
+        for (int j = 0; j < wlen; j++) {
+            w->letters[j] = toupper((uint8_t)ciphertext[start + j]) - 'A';
+        }
+
+        // Skip duplicates
+        int dup = 0;
+        for (int j = 0; j < solver.num_words && !dup; j++) {
+            dup = (solver.words[j].length == wlen &&
+                   memcmp(solver.words[j].letters, w->letters, wlen) == 0);
+        }
+        if (!dup) {
+            solver.num_words++;
+        }
+    }
+
+    // Strict pass first, then allow a few words to be left out (names, typos),
+    // doubling up to a share of the words of a long text
+    int max_skips = (int)(solver.num_words * SUBS_SKIP_FRACTION);
+    max_skips = (max_skips > SUBS_MAX_SKIPS) ? max_skips : SUBS_MAX_SKIPS;
+    solver.best_placed = -1;
+    for (int skips = 0;; skips = (skips == 0) ? 1 : 2 * skips) {
+        skips = (skips < max_skips) ? skips : max_skips;
+        for (int c = 0; c < 26; c++) {
+            solver.map[c] = -1;
+            solver.domain[c] = (1u << 26) - 1;
+        }
+        for (int j = 0; j < solver.num_words; j++) {
+            solver.words[j].resolved = 0;
+        }
+        solver.used = 0;
+        solver.prune = (skips == 0);
+        solver.nodes = 0;
+        solver.placed = 0;
+
+        result = subsSearch(&solver, skips);
+        logMessage(CipherVerboseLevel,
+                   "SUBS pattern search (%d words, %d skips): %s after %ld nodes",
+                   solver.num_words, skips, result == 1 ? "solved" : "failed",
+                   solver.nodes);
+        if (result == 1 || skips == max_skips) {
+            break;
+        }
+    }
+
+    // Nothing fitted every word, fall back on the mapping that fitted the most
+    if (result != 1) {
+        memcpy(solver.map, solver.best_map, sizeof(solver.map));
+        logMessage(CipherVerboseLevel, "SUBS using the best partial mapping (%d of %d words)",
+                   solver.best_placed, solver.num_words);
+    }
+
+    // Key is indexed by plaintext letter, fill unseen letters with the rest
+    uint32_t placed = 0;
+    memset(key, 0, 26);
+    for (int c = 0; c < 26; c++) {
+        if (solver.map[c] >= 0) {
+            key[solver.map[c]] = 'A' + c;
+            placed |= 1u << c;
+        }
+    }
+    for (int p = 0, c = 0; p < 26; p++) {
+        if (key[p] == 0) {
+            while (placed & (1u << c)) {
+                c++;
+            }
+            key[p] = 'A' + c;
+            placed |= 1u << c;
+        }
+    }
+
+    // Decrypt here, cs642Decrypt rejects anything but uppercase and spaces
+    char inverse[26];
+    for (int p = 0; p < 26; p++) {
+        inverse[key[p] - 'A'] = 'A' + p;
+    }
+    int len = (clen < plen) ? clen : plen;
+    for (int i = 0; i < len; i++) {
+        uint8_t ch = (uint8_t)ciphertext[i];
+        plaintext[i] = isalpha(ch) ? inverse[toupper(ch) - 'A'] : ciphertext[i];
+    }
+
+    free(solver.words);
+    return (result == 1) ? 0 : -1;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// Function     : cs642PerformCryptanalysis
+// Description  : Run the cryptanalysis function of a cipher
+//
+// Inputs       : cipher - the cipher
+//                ciphertext - the ciphertext to analyze
+//                clen - the length of the ciphertext
+//                plaintext - the place to put the plaintext in
+//                plen - the length of the plaintext
+//                key - the place to put the key in
+// Outputs      : the cryptanalysis result, -1 if unknown cipher
+
+int cs642PerformCryptanalysis(cs642Cipher cipher, char *ciphertext, int clen,
+                              char *plaintext, int plen, char *key) {
+    switch (cipher) {
+    case CIPHER_ROTX:
+        return cs642PerformROTXCryptanalysis(ciphertext, clen, plaintext, plen, (uint8_t *)key);
+    case CIPHER_AFFI:
+        return cs642PerformAFFICryptanalysis(ciphertext, clen, plaintext, plen, (uint8_t *)key);
+    case CIPHER_VIGE:
+        return cs642PerformVIGECryptanalysis(ciphertext, clen, plaintext, plen, key);
+    case CIPHER_SUBS:
+        return cs642PerformSUBSCryptanalysis(ciphertext, clen, plaintext, plen, key);
+    default:
+        return -1;
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// Function     : cs642OnlineInit
+// Description  : Start estimating the key of a ciphertext stream
+//
+// Inputs       : est - the estimator
+//                cipher - the cipher (ROTX, AFFI or VIGE)
+// Outputs      : 0 if successful, -1 if failure
+//
+// Note: SUBS is not supported, its solver searches whole words and has no
+//       running statistic to update.
+
+int cs642OnlineInit(cs642OnlineEstimator *est, cs642Cipher cipher) {
+    if (cipher != CIPHER_ROTX && cipher != CIPHER_AFFI && cipher != CIPHER_VIGE) {
+        return -1;
+    }
+    memset(est, 0, sizeof(cs642OnlineEstimator));
+    est->cipher = cipher;
+    return 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// Function     : cs642OnlineFeed
+// Description  : Add the next bytes of a ciphertext stream. Each byte updates
+//                the letter counts and, for VIGE, one column of every period.
+//
+// Inputs       : est - the estimator
+//                data - the next bytes of the stream
+//                len - the number of bytes
+// Outputs      : void
+
+void cs642OnlineFeed(cs642OnlineEstimator *est, const char *data, int len) {
+    for (int i = 0; i < len; i++) {
+        int letter = -1;
+        if (isalpha(data[i])) {
+            letter = toupper(data[i]) - 'A';
+            est->letters[letter]++;
+            est->total++;
+        }
+        if (est->cipher != CIPHER_VIGE) {
+            continue;
+        }
+
+        // Spaces still take a key position
+        for (int p = 1, base = 0; p <= VIGE_MAX_PERIOD; base += p, p++) {
+            int col = base + est->column[p];
+            if (letter >= 0) {
+                // n(n-1) grows by 2n when a letter count goes from n to n+1
+                est->col_pairs[col] += 2 * est->col_hist[col][letter];
+                est->col_hist[col][letter]++;
+                est->col_total[col]++;
+            }
+            if (++est->column[p] == p) {
+                est->column[p] = 0;
+            }
+        }
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// Function     : cs642OnlineQuery
+// Description  : Get the current best key of a ciphertext stream
+//
+// Inputs       : est - the estimator
+//                key - the place to put the key in (as for the solvers)
+//                confidence - the place to put the confidence (0-1) in, how
+//                             clearly the key beats the runner up
+// Outputs      : the key length, -1 if failure
+
+int cs642OnlineQuery(cs642OnlineEstimator *est, char *key, double *confidence) {
+    double margin;
+
+    switch (est->cipher) {
+    case CIPHER_ROTX:
+        key[0] = (char)bestAffineShift(est->letters, est->total, 1, confidence);
+        return 1;
+
+    case CIPHER_AFFI: {
+        const cs642Alphabet *english = cs642GetAlphabet(26);
+        int possible_a_values[26];
+        int num_a_values = affineMultipliers(26, possible_a_values);
+        KeyCandidate cands[2];
+        int num_cands = 0;
+
+        // Keep the best two keys for the margin
+        for (int i = 0; i < num_a_values; i++) {
+            for (int b = 0; b < 26; b++) {
+                int a = possible_a_values[i];
+                KeyCandidate cand = {chiSqAffine(english, est->letters, est->total, a, b), a, b};
+                pushCandidate(cands, &num_cands, 2, cand);
+            }
+        }
+        qsort(cands, num_cands, sizeof(KeyCandidate), compareCandidates);
+        key[0] = (char)cands[0].a;
+        key[1] = (char)cands[0].b;
+        *confidence = (est->total > 0 && cands[1].score > 0.0)
+                          ? (cands[1].score - cands[0].score) / cands[1].score : 0.0;
+        return 2;
+    }
+
+    case CIPHER_VIGE: {
+        char letters[VIGE_MAX_PERIOD + 1];
+        int period = onlinePeriod(est);
+        int base = period * (period - 1) / 2;
+
+        // Each column on its own, the confidence is their mean margin
+        *confidence = 0.0;
+        for (int col = 0; col < period; col++) {
+            letters[col] = 'A' + bestAffineShift(est->col_hist[base + col], est->col_total[base + col], 1, &margin);
+            *confidence += margin / period;
+        }
+        letters[period] = '\0';
+        period = shortestKeyPeriod(letters, period);
+        copyVigenereKey(key, letters, period);
+        return strlen(key);
+    }
+
+    default:
+        return -1;
+    }
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -504,6 +2088,12 @@ int cs642StudentCleanUp(void) {
         global_plaintext_buffer = NULL;
     }
 
+    // Free the word indexes and unmap the corpus
+    freePatternIndex();
+    freeDictKeys();
+    cs642NgramRelease();
+    cs642CorpusRelease();
+
     // Return success
     return 0;
 }
@@ -1,3 +1,6 @@
+#ifndef CS642_CRYPTANALYSIS_IMPL_INCLUDED
+#define CS642_CRYPTANALYSIS_IMPL_INCLUDED
+
 ////////////////////////////////////////////////////////////////////////////////
 //
 //  File           : cs642-cryptanalysis-impl.h
@@ -8,6 +11,53 @@
 //   Last Modified : Mon Oct  2 20:46:44 UTC 2023
 
 // Include Files
+#include <stdint.h>
+
+// Project Include Files
+#include "cs642-cryptanalysis-support.h"
+
+//
+// Defines
+
+#define VIGE_MAX_PERIOD 20 // Longest Vigenere period considered
+#define VIGE_ONLINE_COLUMNS (VIGE_MAX_PERIOD * (VIGE_MAX_PERIOD + 1) / 2)
+#define CS642_ALPHABET_MAX 66 // Letters, digits and Latin-1 letters
+
+//
+// Type definitions
+
+// Sign conventions of the Vigenere family (P plaintext, K key, C ciphertext)
+typedef enum {
+  VIGE_VARIANT_VIGENERE = 0,         // C = P + K
+  VIGE_VARIANT_BEAUFORT = 1,         // C = K - P
+  VIGE_VARIANT_VARIANT_BEAUFORT = 2, // C = P - K
+  VIGE_VARIANT_MAX = 3               // Number of variants
+} cs642VigenereVariant;
+
+// A cipher alphabet: its symbols, how text maps onto them and how often each
+// occurs in English plaintext, with the scoring kernels for its size
+typedef struct {
+  int size;                                  // Number of symbols
+  char symbols[CS642_ALPHABET_MAX];          // Symbol of each index (uppercase)
+  int8_t index[256];                         // Index of each byte, -1 if none
+  double expected[CS642_ALPHABET_MAX];       // Expected frequencies (percent)
+  double (*chi_sq_affine)(int n, const int *hist, const double *expected,
+                          int total, int a, int b); // Affine key score
+  void (*affine_table)(int n, int a, int b, uint8_t *table); // Decrypt table
+} cs642Alphabet;
+
+// Running statistics of a ciphertext stream, for estimating the key while the
+// text is still arriving. The columns of every candidate Vigenere period are
+// kept side by side: period p uses columns p(p-1)/2 to p(p+1)/2 - 1.
+typedef struct {
+  cs642Cipher cipher;                        // Cipher being estimated
+  int letters[26];                           // Letter counts of the stream
+  int total;                                 // Letters seen
+  uint8_t column[VIGE_MAX_PERIOD + 1];       // Current column of each period
+  int col_hist[VIGE_ONLINE_COLUMNS][26];     // Letter counts of each column
+  int col_total[VIGE_ONLINE_COLUMNS];        // Letters in each column
+  int64_t col_pairs[VIGE_ONLINE_COLUMNS];    // Sum of n(n-1) over the column
+} cs642OnlineEstimator;
 
 //
 // Implementation functions
@@ -24,15 +74,59 @@ int cs642PerformAFFICryptanalysis(char *ciphertext, int clen, char *plaintext,
                                   int plen, uint8_t *key);
 // This is the function to cryptanalyze the Affine cipher
 
+int cs642PerformAlphabetAFFICryptanalysis(const cs642Alphabet *alpha,
+                                          char *ciphertext, int clen,
+                                          char *plaintext, int plen,
+                                          uint8_t *key);
+// This is the function to cryptanalyze the Affine cipher over any alphabet
+
 int cs642PerformVIGECryptanalysis(char *ciphertext, int clen, char *plaintext,
                                   int plen, char *key);
 // This is the function to cryptanalyze the Vigenere cipher
 
+int cs642PerformVIGEFamilyCryptanalysis(char *ciphertext, int clen,
+                                        char *plaintext, int plen, char *key,
+                                        cs642VigenereVariant *variant);
+// This is the function to cryptanalyze a Vigenere family cipher whose sign
+// convention is unknown, reporting the variant that fits best. Variant
+// Beaufort is Vigenere under the negated key and the two cannot be told apart
+// from the ciphertext, so it is never reported: such a ciphertext comes back
+// as Vigenere with the negated key (which decrypts it the same)
+
 int cs642PerformSUBSCryptanalysis(char *ciphertext, int clen, char *plaintext,
                                   int plen, char *key);
 // This is the function to cryptanalyze the substitution cipher
 
+int cs642PerformCryptanalysis(cs642Cipher cipher, char *ciphertext, int clen,
+                              char *plaintext, int plen, char *key);
+// This is the function to run the cryptanalysis of any of the ciphers above
+
+int cs642OnlineInit(cs642OnlineEstimator *est, cs642Cipher cipher);
+// Start estimating the key of a ciphertext stream (ROTX, AFFI or VIGE)
+
+void cs642OnlineFeed(cs642OnlineEstimator *est, const char *data, int len);
+// Add the next bytes of the stream, in constant time per byte
+
+int cs642OnlineQuery(cs642OnlineEstimator *est, char *key, double *confidence);
+// Get the current best key and its confidence (0-1); the cost does not depend
+// on how much has been fed. Returns the key length, -1 if failure
+
+const cs642Alphabet *cs642GetAlphabet(int size);
+// Get the alphabet of a size: 26 (English letters), 36 (and digits), 56
+// (English and Latin-1 letters) or 66 (all three), NULL if there is none
+
+void encryptAffine(const cs642Alphabet *alpha, const char *plaintext, int len,
+                   char *ciphertext, int a, int b);
+// Encrypt with the Affine key (a, b) over an alphabet, symbols outside it are
+// copied (ciphertext gets len + 1 chars)
+
+int affineMultipliers(int n, int *values);
+// List the valid Affine 'a' values for an alphabet of n letters (those
+// invertible modulo n), returns the number of values
+
 int cs642StudentCleanUp(void);
 // This is a clean up function called at the end of the cryptanalysis of the
 // different ciphers. Use it if you need to release  memory you allocated in
 // cs642StudentInit() for instance.
+
+#endif
@@ -0,0 +1,139 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+//  File           : cs642-cryptanalysis-ngram.c
+//  Description    : This is the letter n-gram model of the text corpus. The
+//                   corpus is read as the ciphertexts are written (uppercase
+//                   letters, every run of other characters one space) and the
+//                   trigram counts are turned into log10 probabilities, with a
+//                   floor for trigrams the corpus never shows. The model in
+//                   the corpus snapshot is used as is when there is one.
+//
+//   Author        : Max Mitchell
+//   Last Modified : October 19th, 2026
+//
+
+// Include Files
+#include <compsci642_log.h>
+#include <ctype.h>
+#include <math.h>
+#include <stdlib.h>
+
+// Project Include Files
+#include "cs642-cryptanalysis-support.h"
+#include "cs642-cryptanalysis-corpus.h"
+#include "cs642-cryptanalysis-ngram.h"
+
+// Defines
+#define NGRAM_TRIGRAMS (NGRAM_SYMBOLS * NGRAM_SYMBOLS * NGRAM_SYMBOLS)
+#define NGRAM_UNSEEN_COUNT 0.1 // Pseudo count of a trigram never seen
+
+// Global Data
+
+const float *ngram_trigrams = NULL; // log10 P(trigram)
+float *ngram_built = NULL;           // The table, if built here
+float ngram_trigram_mean = 0.0f;
+
+//
+// Functions
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// Function     : ngramBuild
+// Description  : Helper function to count the corpus trigrams and convert the
+//                counts to log10 probabilities
+//
+// Inputs       : void
+// Outputs      : 0 if successful, -1 if failure
+
+int ngramBuild(void) {
+    size_t tlen;
+    const char *text = cs642CorpusText(&tlen);
+    if (text == NULL) {
+        return -1;
+    }
+
+    int *counts = (int *)calloc(NGRAM_TRIGRAMS, sizeof(int));
+    float *table = (float *)malloc(NGRAM_TRIGRAMS * sizeof(float));
+    if (counts == NULL || table == NULL) {
+        free(counts);
+        free(table);
+        return -1;
+    }
+
+    // Slide over the normalized text (runs of non-letters are one space)
+    int a = 26, b = 26, total = 0;
+    for (size_t i = 0; i < tlen; i++) {
+        uint8_t ch = (uint8_t)text[i];
+        int c = isalpha(ch) ? toupper(ch) - 'A' : 26;
+        if (c == 26 && b == 26) {
+            continue;
+        }
+        counts[NGRAM_TRIGRAM(a, b, c)]++;
+        total++;
+        a = b;
+        b = c;
+    }
+
+    double mean = 0.0;
+    for (int t = 0; t < NGRAM_TRIGRAMS; t++) {
+        double count = (counts[t] > 0) ? counts[t] : NGRAM_UNSEEN_COUNT;
+        table[t] = (float)log10(count / total);
+        mean += counts[t] * (double)table[t];
+    }
+    free(counts);
+
+    ngram_built = table;
+    ngram_trigrams = table;
+    ngram_trigram_mean = (float)(mean / total);
+    logMessage(CipherVerboseLevel, "Built trigram model [%d] trigrams, mean log10 P %.3f",
+               total, ngram_trigram_mean);
+    return 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// Function     : cs642NgramTrigrams
+// Description  : Get the trigram log10 probabilities, from the corpus
+//                snapshot or built on first use
+//
+// Inputs       : void
+// Outputs      : the table (NGRAM_TRIGRAM indexed), NULL if failure
+
+const float *cs642NgramTrigrams(void) {
+    if (ngram_trigrams == NULL) {
+        ngram_trigrams = cs642CorpusSnapshotTrigrams(&ngram_trigram_mean);
+    }
+    if (ngram_trigrams == NULL && ngramBuild()) {
+        return NULL;
+    }
+    return ngram_trigrams;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// Function     : cs642NgramTrigramMean
+// Description  : Get the mean trigram log10 probability of the corpus text,
+//                i.e. the score per character expected of English
+//
+// Inputs       : void
+// Outputs      : the mean (0 if the corpus cannot be loaded)
+
+float cs642NgramTrigramMean(void) {
+    cs642NgramTrigrams();
+    return ngram_trigram_mean;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// Function     : cs642NgramRelease
+// Description  : Free the n-gram tables
+//
+// Inputs       : void
+// Outputs      : void
+
+void cs642NgramRelease(void) {
+    free(ngram_built);
+    ngram_built = NULL;
+    ngram_trigrams = NULL;
+    ngram_trigram_mean = 0.0f;
+}
@@ -0,0 +1,37 @@
+#ifndef CS642_CRYPTANALYSIS_NGRAM_INCLUDED
+#define CS642_CRYPTANALYSIS_NGRAM_INCLUDED
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  File           : cs642-cryptanalysis-ngram.h
+//  Description    : This is an include file for the letter n-gram statistics
+//                   of the text corpus, used to score candidate plaintexts.
+//                   Symbols are the 26 letters and the word space; the tables
+//                   hold log10 probabilities and are built on first use.
+//
+//   Author        : Max Mitchell
+//   Last Modified : October 19th, 2026
+//
+
+//
+// Defines
+
+#define NGRAM_SYMBOLS 27 // A-Z, then the space
+
+// Index of a trigram of symbols in the trigram table
+#define NGRAM_TRIGRAM(a, b, c) (((a) * NGRAM_SYMBOLS + (b)) * NGRAM_SYMBOLS + (c))
+
+//
+// Functions
+
+const float *cs642NgramTrigrams(void);
+// Get the trigram log10 probabilities (NGRAM_TRIGRAM indexed), NULL if the
+// corpus cannot be loaded (the snapshot's model when there is one)
+
+float cs642NgramTrigramMean(void);
+// Get the mean trigram log10 probability of the corpus text itself
+
+void cs642NgramRelease(void);
+// Free the n-gram tables (call before releasing the corpus)
+
+#endif
@@ -1,3 +1,6 @@
+#ifndef CS642_CRYPTANALYSIS_SUPPORT_INCLUDED
+#define CS642_CRYPTANALYSIS_SUPPORT_INCLUDED
+
 ////////////////////////////////////////////////////////////////////////////////
 //
 //  File           : cs642-cryptanalysis-support.h
@@ -79,3 +82,5 @@ int cs642CipherUnittest(void);
 
 int cs642CleanCipherStructures(void);
 // cleanup all of the plaintext file structures
+
+#endif
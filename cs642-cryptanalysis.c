@@ -12,19 +12,44 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
 #include <unistd.h>
 
 // Project Include Files
-#include "cs642-cryptanalysis-impl.h"
 #include "cs642-cryptanalysis-support.h"
+#include "cs642-cryptanalysis-impl.h"
+#include "cs642-cryptanalysis-characterize.h"
+#include "cs642-cryptanalysis-batch.h"
+#include "cs642-cryptanalysis-corpus.h"
+#include "cs642-cryptanalysis-ngram.h"
 
 // Defines
-#define cs642_CRYPTANALYSIS_ARGUMENTS "vuh"
+#define cs642_CRYPTANALYSIS_ARGUMENTS "vuhwdfa:e:s:l:g:b:k:o:m:"
 #define cs642_CRYPTANALYSIS_USAGE                                              \
   "\n"                                                                         \
-  "  cryptanalysis -c <cipher> [-v] [-u] [-h]\n\n"                             \
+  "  cryptanalysis -c <cipher> [-v] [-u] [-h]\n"                              \
+  "                [-s <trials> [-l <lengths>] [-d] [-f] [-a <size>]]\n"      \
+  "                [-g <count>] [-b <records> [-k <i>/<n>] -o <output>]\n"     \
+  "                [-m <n> -o <output>] [-w] [-e <trials>]\n\n"               \
   "  where:\n"                                                                 \
   "     -u - runs the unit test (no cipher needed)\n"                          \
+  "     -s - characterizes every solver with <trials> trials per length,\n"    \
+  "          writing the accuracy-vs-length results as CSV to stdout\n"       \
+  "     -l - comma separated plaintext lengths for -s\n"                      \
+  "     -d - uses 6-11 letter dictionary words as the Vigenere keys for -s\n"  \
+  "     -f - characterizes the Vigenere family solver for -s instead, under\n" \
+  "          each sign convention (Vigenere, Beaufort, variant Beaufort)\n"  \
+  "     -a - characterizes the Affine solver for -s instead, over the <size>\n" \
+  "          symbol alphabet (26, 36 with digits, 56 with Latin-1, 66 all)\n" \
+  "     -g - writes <count> random sample records to stdout\n"                \
+  "     -b - solves the records of one shard of the <records> file, writing\n" \
+  "          the results to <output>.<i>\n"                                   \
+  "     -k - the shard to solve, <i> of <n> (default 0/1)\n"                  \
+  "     -m - merges <output>.0 to <output>.<n-1> into <output>\n"             \
+  "     -o - the batch output name for -b and -m\n"                           \
+  "     -w - writes the corpus snapshot (word table and trigram model)\n"     \
+  "     -e - checks the online key estimator against the solvers on <trials>\n" \
+  "          samples per cipher, writing the results as CSV to stdout\n"     \
   "     -v - verbose mode (display all logging messages)\n"                    \
   "     -h - displays this help message, and returns\n\n"
 #define CS642_CRYPTANALYSIS_TESTS 3
@@ -52,7 +77,12 @@ int main(int argc, char *argv[]) {
 
   // Local variables
   int ch, log_initialized = 0, unit_tests = 0, keylen, i, clen;
+  int char_trials = 0, char_word_keys = 0, char_family = 0, char_alphabet = 0,
+      char_lengths[CS642_CHARACTERIZE_MAX_LENGTHS], num_char_lengths, char_result;
+  int online_trials = 0, write_snapshot = 0, gen_records = 0, shard = 0, num_shards = 1, merge_shards = 0;
+  const char *batch_records = NULL, *batch_output = NULL;
   char *ciphertext, *plaintext, *key;
+  const char *lengths_arg = CS642_CHARACTERIZE_DEFAULT_LENGTHS;
   cs642Cipher cipher = CIPHER_UNK;
 
   // Process the command line parameters
@@ -66,6 +96,77 @@ int main(int argc, char *argv[]) {
       unit_tests = 1;
       break;
 
+    case 's': // Characterize the solvers
+      char_trials = atoi(optarg);
+      if (char_trials <= 0) {
+        fprintf(stderr, "Bad trial count (%s), aborting.\n", optarg);
+        return (-1);
+      }
+      break;
+
+    case 'l': // Lengths for the characterization
+      lengths_arg = optarg;
+      break;
+
+    case 'd': // Dictionary word Vigenere keys for the characterization
+      char_word_keys = 1;
+      break;
+
+    case 'f': // Vigenere family characterization
+      char_family = 1;
+      break;
+
+    case 'a': // Alphabet for the Affine characterization
+      char_alphabet = atoi(optarg);
+      if (cs642GetAlphabet(char_alphabet) == NULL) {
+        fprintf(stderr, "Bad alphabet size (%s), aborting.\n", optarg);
+        return (-1);
+      }
+      break;
+
+    case 'e': // Check the online estimator
+      online_trials = atoi(optarg);
+      if (online_trials <= 0) {
+        fprintf(stderr, "Bad trial count (%s), aborting.\n", optarg);
+        return (-1);
+      }
+      break;
+
+    case 'w': // Write the corpus snapshot
+      write_snapshot = 1;
+      break;
+
+    case 'g': // Generate sample records
+      gen_records = atoi(optarg);
+      if (gen_records <= 0) {
+        fprintf(stderr, "Bad record count (%s), aborting.\n", optarg);
+        return (-1);
+      }
+      break;
+
+    case 'b': // Batch record file
+      batch_records = optarg;
+      break;
+
+    case 'k': // Batch shard
+      if (cs642ParseShard(optarg, &shard, &num_shards)) {
+        fprintf(stderr, "Bad shard (%s), aborting.\n", optarg);
+        return (-1);
+      }
+      break;
+
+    case 'o': // Batch output
+      batch_output = optarg;
+      break;
+
+    case 'm': // Merge the batch shards
+      merge_shards = atoi(optarg);
+      if (merge_shards <= 0 || merge_shards > CS642_BATCH_MAX_SHARDS) {
+        fprintf(stderr, "Bad shard count (%s), aborting.\n", optarg);
+        return (-1);
+      }
+      break;
+
     case 'h': // Help Flag
       fprintf(stderr, cs642_CRYPTANALYSIS_USAGE);
       return (0);
@@ -87,6 +188,96 @@ int main(int argc, char *argv[]) {
     enableLogLevels(CipherVerboseLevel);
   }
 
+  // Run the characterization sweep
+  if (char_trials > 0) {
+    num_char_lengths = cs642ParseLengths(lengths_arg, char_lengths,
+                                         CS642_CHARACTERIZE_MAX_LENGTHS);
+    if (num_char_lengths < 0) {
+      fprintf(stderr, "Bad length list (%s), aborting.\n", lengths_arg);
+      return (-1);
+    }
+    srand(time(NULL) ^ getpid());
+    if (cs642StudentInit()) {
+      char_result = -1;
+    } else if (char_alphabet > 0) {
+      char_result = cs642CharacterizeAlphabet(char_trials, char_lengths,
+                                              num_char_lengths, char_alphabet,
+                                              stdout);
+    } else if (char_family) {
+      char_result = cs642CharacterizeVigenereFamily(char_trials, char_lengths,
+                                                    num_char_lengths,
+                                                    char_word_keys, stdout);
+    } else {
+      char_result = cs642CharacterizeSolvers(char_trials, char_lengths,
+                                             num_char_lengths, char_word_keys,
+                                             stdout);
+    }
+    if (char_result) {
+      logMessage(LOG_ERROR_LEVEL, "Solver characterization failed, aborting.");
+      exit(-1);
+    }
+    cs642StudentCleanUp();
+    return (0);
+  }
+
+  // Check the online estimator against the solvers
+  if (online_trials > 0) {
+    cs642StartProject();
+    if (cs642StudentInit()) {
+      logMessage(LOG_ERROR_LEVEL, "cs642StudentInit failed, aborting program.");
+      exit(-1);
+    }
+    if (cs642CheckOnlineEstimator(online_trials, stdout)) {
+      logMessage(LOG_ERROR_LEVEL, "Online estimator check failed.");
+      exit(-1);
+    }
+    cs642StudentCleanUp();
+    cs642CleanCipherStructures();
+    return (0);
+  }
+
+  // Write the corpus snapshot for fast startup
+  if (write_snapshot) {
+    if (cs642CorpusWriteSnapshot(cs642NgramTrigrams(),
+                                 cs642NgramTrigramMean())) {
+      logMessage(LOG_ERROR_LEVEL, "Writing the corpus snapshot failed.");
+      exit(-1);
+    }
+    cs642NgramRelease();
+    cs642CorpusRelease();
+    return (0);
+  }
+
+  // Write sample records for the batch runner
+  if (gen_records > 0) {
+    cs642StartProject();
+    if (cs642BatchGenerate(gen_records, stdout)) {
+      logMessage(LOG_ERROR_LEVEL, "Record generation failed, aborting.");
+      exit(-1);
+    }
+    cs642CleanCipherStructures();
+    return (0);
+  }
+
+  // Run one shard of a batch, or merge the shards
+  if (batch_records != NULL || merge_shards > 0) {
+    if (batch_output == NULL) {
+      fprintf(stderr, "Batch mode needs an output (-o), aborting.\n");
+      return (-1);
+    }
+    if (merge_shards > 0) {
+      return (cs642BatchMerge(batch_output, merge_shards) ? -1 : 0);
+    }
+    if (cs642StudentInit() ||
+        cs642BatchRunShard(batch_records, shard, num_shards, batch_output)) {
+      logMessage(LOG_ERROR_LEVEL, "Batch shard %d/%d failed, aborting.", shard,
+                 num_shards);
+      exit(-1);
+    }
+    cs642StudentCleanUp();
+    return (0);
+  }
+
   // Run the unit tests
   if (unit_tests) {
     if (cs642CipherUnittest()) {